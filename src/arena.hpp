@@ -0,0 +1,81 @@
+#ifndef ARENA_HPP_
+#define ARENA_HPP_
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Bump allocator for circuit nodes. Nodes are never freed one at a time:
+// the owner destroys them and then releases the whole arena at once,
+// which keeps the blocks around so the next circuit can reuse them.
+struct NodeArena {
+    struct Block {
+        char *data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    size_t block_size;
+    size_t current, offset;
+
+    // allocations and bytes handed out since the last release
+    size_t n_allocations, bytes_used;
+    // memory actually held, including free space kept for reuse
+    size_t bytes_reserved;
+
+    NodeArena(size_t _block_size = 1 << 16) : block_size(_block_size), current(0), offset(0),
+        n_allocations(0), bytes_used(0), bytes_reserved(0) {}
+
+    NodeArena(const NodeArena &) = delete;
+    NodeArena & operator=(const NodeArena &) = delete;
+
+    ~NodeArena() {
+        for (Block &block : blocks) {
+            ::operator delete(block.data);
+        }
+    }
+
+    void * allocate(size_t size, size_t align) {
+        while (true) {
+            if (current < blocks.size()) {
+                size_t start = (offset + align - 1) & ~(align - 1);
+                if (start + size <= blocks[current].size) {
+                    offset = start + size;
+                    n_allocations += 1;
+                    bytes_used += size;
+                    return blocks[current].data + start;
+                }
+                if (offset > 0) {
+                    current += 1;
+                    offset = 0;
+                    continue;
+                }
+            }
+            // no block left that fits, so add one right here; oversized
+            // requests get a block of their own
+            size_t new_size = size > block_size ? size : block_size;
+            Block block = {static_cast<char *>(::operator new(new_size)), new_size};
+            blocks.insert(blocks.begin() + current, block);
+            bytes_reserved += new_size;
+            offset = 0;
+        }
+    }
+
+    template<typename T, typename... Args>
+    T * make(Args&&... args) {
+        void *mem = allocate(sizeof(T), alignof(T));
+        return new (mem) T(std::forward<Args>(args)...);
+    }
+
+    // forgets every allocation but keeps the blocks; destructors of
+    // anything still living in the arena have to be run beforehand
+    void release() {
+        current = 0;
+        offset = 0;
+        n_allocations = 0;
+        bytes_used = 0;
+    }
+};
+
+#endif // ARENA_HPP_
@@ -0,0 +1,237 @@
+#ifndef AUCTION_HPP_
+#define AUCTION_HPP_
+
+#include <vector>
+
+#include "zksystem.hpp"
+
+// x if c is 1 and y if c is 0, for a boolean c: one product
+inline FieldElem & mux(FieldElem &c, FieldElem &x, FieldElem &y) {
+    return y + c * (x - y);
+}
+
+// bits needed to tell n_bids bidders apart
+inline size_t rank_bits(size_t n_bids) {
+    size_t bits = 0;
+    while ((1ULL << bits) < n_bids) {
+        bits += 1;
+    }
+    return bits;
+}
+
+// Bids are made unique by appending the bidder's rank in index_bits low
+// bits, reversed so that on equal bids the lower index has the larger key.
+inline FieldElem & bid_key(BitArray &bid, size_t i, size_t n_bids, size_t index_bits) {
+    ZKSystem &system = bid.system;
+    return bid.to_field_elem() * system.power_of_two(index_bits) + system.constant((long) (n_bids - 1 - i));
+}
+
+// Sealed-bid second-price auction over any number of bids of the same
+// width. The bids play a knockout tournament, N - 1 packed comparisons,
+// and every entrant carries the keys it has beaten along; the runner-up
+// is then the largest of the champion's ceil(log2 N) victims, since
+// anyone else lost to somebody who isn't the champion. The bits of the
+// two top keys give the winner's index and the price. Ties go to the
+// lower index.
+struct SecondPriceAuction {
+    ZKSystem &system;
+    size_t n_bids, bid_bits, index_bits;
+    // 0-based index of the highest bid, and the second highest bid
+    FieldElem *winner, *price;
+
+    SecondPriceAuction(std::vector<BitArray> &bids) : system(bids.at(0).system), n_bids(bids.size()),
+        bid_bits(bids[0].size), index_bits(0), winner(nullptr), price(nullptr) {
+        if (n_bids < 2) {
+            std::cout << "A second-price auction needs at least two bids" << std::endl;
+            throw 1;
+        }
+        index_bits = rank_bits(n_bids);
+        const size_t width = bid_bits + index_bits;
+
+        struct Entrant {
+            FieldElem *key;
+            std::vector<FieldElem *> beaten;
+        };
+
+        std::vector<Entrant> round;
+        for (size_t i = 0; i < n_bids; i++) {
+            if (bids[i].size != (int) bid_bits) {
+                std::cout << "All bids need the same number of bits" << std::endl;
+                throw 1;
+            }
+            round.push_back(Entrant{&bid_key(bids[i], i, n_bids, index_bits), {}});
+        }
+
+        while (round.size() > 1) {
+            std::vector<Entrant> next;
+            for (size_t i = 0; i + 1 < round.size(); i += 2) {
+                Entrant &x = round[i];
+                Entrant &y = round[i + 1];
+                // keys are distinct, so strict and non-strict agree
+                FieldElem &c = packed_compare(*x.key, *y.key, width, true);
+                FieldElem &top = mux(c, *x.key, *y.key);
+                FieldElem &loser = *x.key + *y.key - top;
+
+                Entrant merged{&top, {}};
+                const size_t n = std::max(x.beaten.size(), y.beaten.size());
+                for (size_t j = 0; j < n; j++) {
+                    FieldElem &kx = j < x.beaten.size() ? *x.beaten[j] : system.constant(0L);
+                    FieldElem &ky = j < y.beaten.size() ? *y.beaten[j] : system.constant(0L);
+                    merged.beaten.push_back(&mux(c, kx, ky));
+                }
+                merged.beaten.push_back(&loser);
+                next.push_back(merged);
+            }
+            if (round.size() % 2) {
+                next.push_back(round.back());
+            }
+            round.swap(next);
+        }
+
+        FieldElem *second = round[0].beaten[0];
+        for (size_t j = 1; j < round[0].beaten.size(); j++) {
+            FieldElem &c = packed_compare(*round[0].beaten[j], *second, width, true);
+            second = &mux(c, *round[0].beaten[j], *second);
+        }
+
+        BitArray top_bits(*round[0].key, width);
+        BitArray second_bits(*second, width);
+        std::vector<FieldElem *> rank(top_bits.bits.begin() + bid_bits, top_bits.bits.end());
+        std::vector<FieldElem *> amount(second_bits.bits.begin(), second_bits.bits.begin() + bid_bits);
+        winner = &((int) (n_bids - 1) - BitArray(system, rank).to_field_elem());
+        price = &BitArray(system, amount).to_field_elem();
+    }
+};
+
+// Sorts keys[begin, begin + n) largest first when descending is set,
+// smallest first otherwise.
+struct SelectionNetwork {
+    ZKSystem &system;
+    size_t width;
+    size_t n_comparators;
+
+    SelectionNetwork(ZKSystem &_system, size_t _width) : system(_system), width(_width), n_comparators(0) {}
+
+    // one comparison and one product; the smaller key is linear in the
+    // other two. Keys pass through O(N / p log p) comparators on their
+    // way to the top, so the outputs are pinned to keep every key one
+    // term long, two constraints more per comparator.
+    void compare_exchange(std::vector<FieldElem *> &keys, size_t i, size_t j, bool descending) {
+        FieldElem &c = packed_compare(*keys[i], *keys[j], width, true);
+        FieldElem &top = mux(c, *keys[i], *keys[j]);
+        FieldElem &bottom = *keys[i] + *keys[j] - top;
+        top.pin();
+        bottom.pin();
+        keys[i] = descending ? &top : &bottom;
+        keys[j] = descending ? &bottom : &top;
+        n_comparators += 1;
+    }
+
+    // sorts a bitonic run of n (a power of two) keys
+    void merge(std::vector<FieldElem *> &keys, size_t begin, size_t n, bool descending) {
+        for (size_t stride = n / 2; stride > 0; stride /= 2) {
+            for (size_t i = begin; i < begin + n; i++) {
+                if (((i - begin) & stride) == 0) {
+                    compare_exchange(keys, i, i + stride, descending);
+                }
+            }
+        }
+    }
+
+    // bitonic sort of n (a power of two) keys, n log^2 n / 4 comparators
+    void sort(std::vector<FieldElem *> &keys, size_t begin, size_t n, bool descending) {
+        if (n < 2) {
+            return;
+        }
+        sort(keys, begin, n / 2, descending);
+        sort(keys, begin + n / 2, n / 2, !descending);
+        merge(keys, begin, n, descending);
+    }
+
+    // Both runs hold p keys sorted largest first. The larger of top[j]
+    // and other[p - 1 - j] form a bitonic run holding the p largest keys
+    // of the two, which merge() then sorts: p / 2 log p + p comparators.
+    void keep_top(std::vector<FieldElem *> &top, const std::vector<FieldElem *> &other) {
+        const size_t p = top.size();
+        for (size_t j = 0; j < p; j++) {
+            FieldElem &x = *top[j];
+            FieldElem &y = *other[p - 1 - j];
+            top[j] = &mux(packed_compare(x, y, width, true), x, y);
+            top[j]->pin();
+            n_comparators += 1;
+        }
+        merge(top, 0, p, true);
+    }
+};
+
+// Uniform-price auction: the k highest bids win, and all pay the
+// (k + 1)-th highest bid. Only the k + 1 largest keys are needed, so
+// instead of a full sort the bids are cut into blocks of p, the next
+// power of two at least k + 1, and each block is bitonic sorted and
+// folded into the running top p. That is O(N log^2 k) comparators. A bid
+// wins if its key beats the clearing key, one more comparison per bid.
+// Keys are built as for SecondPriceAuction, so ties go to the lower
+// index.
+struct UniformPriceAuction {
+    ZKSystem &system;
+    size_t n_bids, n_winners, bid_bits, index_bits;
+    // 1 for each of the k winning bids and 0 for the others
+    std::vector<FieldElem *> winners;
+    FieldElem *price;
+    size_t n_comparators;
+
+    UniformPriceAuction(std::vector<BitArray> &bids, size_t k) : system(bids.at(0).system), n_bids(bids.size()),
+        n_winners(k), bid_bits(bids[0].size), index_bits(rank_bits(bids.size())), price(nullptr), n_comparators(0) {
+        if (k < 1 || k >= n_bids) {
+            std::cout << "A uniform-price auction needs between 1 and N - 1 winners" << std::endl;
+            throw 1;
+        }
+        const size_t width = bid_bits + index_bits;
+
+        std::vector<FieldElem *> bid_keys;
+        for (size_t i = 0; i < n_bids; i++) {
+            if (bids[i].size != (int) bid_bits) {
+                std::cout << "All bids need the same number of bits" << std::endl;
+                throw 1;
+            }
+            bid_keys.push_back(&bid_key(bids[i], i, n_bids, index_bits));
+        }
+
+        std::vector<FieldElem *> keys(bid_keys);
+
+        size_t p = 1;
+        while (p < k + 1) {
+            p *= 2;
+        }
+        // padding keys lose to every real key but one of value 0, which
+        // is the last bid at 0 and can only ever tie on the price
+        while (keys.size() % p) {
+            keys.push_back(&system.constant(0L));
+        }
+
+        SelectionNetwork network(system, width);
+        std::vector<FieldElem *> top;
+        for (size_t begin = 0; begin < keys.size(); begin += p) {
+            network.sort(keys, begin, p, true);
+            std::vector<FieldElem *> block(keys.begin() + begin, keys.begin() + begin + p);
+            if (begin == 0) {
+                top = block;
+            } else {
+                network.keep_top(top, block);
+            }
+        }
+        n_comparators = network.n_comparators;
+
+        FieldElem &clearing = *top[k];
+        for (size_t i = 0; i < n_bids; i++) {
+            winners.push_back(&packed_compare(*bid_keys[i], clearing, width, true));
+        }
+
+        BitArray clearing_bits(clearing, width);
+        std::vector<FieldElem *> amount(clearing_bits.bits.begin(), clearing_bits.bits.begin() + bid_bits);
+        price = &BitArray(system, amount).to_field_elem();
+    }
+
+};
+
+#endif // AUCTION_HPP_
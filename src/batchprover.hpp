@@ -0,0 +1,140 @@
+#ifndef BATCHPROVER_HPP_
+#define BATCHPROVER_HPP_
+
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef MULTICORE
+#include <omp.h>
+#endif
+
+#include "zksystem.hpp"
+#include "profiling.hpp"
+
+// a proof together with the public inputs it has to be verified against
+struct ProvedInstance {
+    r1cs_primary_input<FieldT> primary_input;
+    Proof proof;
+};
+
+// Proves many instances of one compiled circuit with one proving key.
+// Workers take turns on the system to fill in an instance's witness and
+// copy it out, then prove it on their own while the next worker uses
+// the system. Witness generation is cheap next to proving, so the lock
+// is rarely contended.
+//
+// Proofs are independent, so running them side by side scales almost
+// perfectly, while the prover's own OpenMP regions (multi-exponentiation
+// and FFTs) scale worse as threads are added. So there is one worker per
+// core as long as there are enough instances, and leftover cores are
+// shared out as OpenMP threads inside each proof.
+//
+// The prover logs its progress through libff's profiling, which keeps
+// global state without a lock, so profiling is turned off for the
+// duration of a batch rather than proving one instance at a time.
+struct BatchProver {
+    ZKSystem &system;
+    std::shared_ptr<const ProvingKey> pk;
+    size_t n_threads;
+
+    // how the last batch was split up
+    size_t n_workers, threads_per_proof;
+
+    BatchProver(ZKSystem &_system, std::shared_ptr<const ProvingKey> _pk, size_t _n_threads = 0) :
+        system(_system), pk(_pk), n_threads(_n_threads), n_workers(0), threads_per_proof(0) {
+        if (n_threads == 0) {
+            n_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+    }
+
+    // assign(i) sets the inputs of instance i; results are in instance
+    // order
+    std::vector<ProvedInstance> prove(size_t n, std::function<void(size_t)> assign) {
+        std::vector<ProvedInstance> results(n);
+        if (n == 0) {
+            return results;
+        }
+        n_workers = std::min(n, n_threads);
+        threads_per_proof = n_threads / n_workers;
+#ifdef MULTICORE
+        // the calling thread works too, so put its setting back after
+        const int caller_threads = omp_get_max_threads();
+#endif
+        ProfilingOff quiet;
+
+        std::mutex lock;
+        size_t next = 0;
+        std::exception_ptr error;
+
+        auto work = [&]() {
+#ifdef MULTICORE
+            omp_set_num_threads(threads_per_proof);
+#endif
+            r1cs_auxiliary_input<FieldT> auxiliary_input;
+            while (true) {
+                size_t i;
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    if (next == n || error) {
+                        return;
+                    }
+                    i = next++;
+                    try {
+                        system.reset_witness();
+                        assign(i);
+                        system.export_witness(results[i].primary_input, auxiliary_input);
+                    } catch (...) {
+                        error = std::current_exception();
+                        return;
+                    }
+                }
+                // an exception escaping a worker thread would terminate
+                // the process, so it is handed to the caller instead
+                try {
+                    results[i].proof = r1cs_ppzksnark_prover<default_r1cs_ppzksnark_pp>(*pk, results[i].primary_input, auxiliary_input);
+                } catch (...) {
+                    std::lock_guard<std::mutex> guard(lock);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    return;
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t w = 1; w < n_workers; w++) {
+            workers.emplace_back(work);
+        }
+        work();
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+#ifdef MULTICORE
+        omp_set_num_threads(caller_threads);
+#endif
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return results;
+    }
+
+    // one auction per assignment, giving each bid its value in turn
+    std::vector<ProvedInstance> prove(std::vector<BitArray> &bids, const std::vector<std::vector<unsigned long long> > &assignments) {
+        return prove(assignments.size(), [&](size_t i) {
+            if (assignments[i].size() != bids.size()) {
+                std::cout << "Assignment " << i << " has " << assignments[i].size() << " bids instead of " << bids.size() << std::endl;
+                throw 1;
+            }
+            for (size_t j = 0; j < bids.size(); j++) {
+                bids[j].set(assignments[i][j]);
+            }
+        });
+    }
+};
+
+#endif // BATCHPROVER_HPP_
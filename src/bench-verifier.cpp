@@ -0,0 +1,94 @@
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "zksystem.hpp"
+#include "auction.hpp"
+
+// Per-proof verification latency for auction circuits, re-processing the
+// verification key on every call (r1cs_ppzksnark_verifier_strong_IC)
+// against processing it once and using the online verifier.
+//
+//   bench-verifier [verifications per circuit]
+
+typedef std::chrono::steady_clock Clock;
+
+double micros_since(Clock::time_point start, size_t n = 1) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / n;
+}
+
+void bench(const std::string &label, ZKSystem &system, std::vector<BitArray> &bids, size_t rounds) {
+  std::mt19937_64 rng(1);
+  for (BitArray &bid : bids) {
+    bid.set((unsigned long long) (rng() >> (64 - bid.size)));
+  }
+
+  const KeyPair keypair = system.make_keypair();
+  const Proof proof = system.make_proof(keypair);
+
+  bool ok = true;
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < rounds; i++) {
+    ok = system.verify_proof(keypair.vk, proof) && ok;
+  }
+  const double plain = micros_since(start, rounds);
+
+  start = Clock::now();
+  const ProcessedVerificationKey pvk = system.process_key(keypair.vk);
+  const double process = micros_since(start);
+
+  start = Clock::now();
+  for (size_t i = 0; i < rounds; i++) {
+    ok = system.verify_proof(pvk, proof) && ok;
+  }
+  const double online = micros_since(start, rounds);
+
+  cout << label << ": " << system.pb.num_constraints() << " constraints, "
+       << system.pb.num_inputs() << " inputs" << endl;
+  cout << "  strong_IC        " << plain << " us/proof" << endl;
+  cout << "  process_vk once  " << process << " us" << endl;
+  cout << "  online           " << online << " us/proof (" << (plain - online) << " us saved"
+       << (plain > 0 ? ", " + std::to_string((int) (100 * (plain - online) / plain)) + "%" : "") << ")" << endl;
+  if (!ok) {
+    cout << "  verification failed" << endl;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const size_t rounds = argc > 1 ? atoi(argv[1]) : 100;
+
+  for (size_t n : {3, 16, 64}) {
+    ZKSystem system;
+    std::vector<BitArray> bids;
+    for (size_t i = 0; i < n; i++) {
+      bids.emplace_back(system, "bid" + std::to_string(i), 32);
+    }
+    SecondPriceAuction auction(bids);
+    auction.winner->make_public();
+    auction.price->make_public();
+    system.compile();
+
+    bench("second price, " + std::to_string(n) + " bids", system, bids, rounds);
+  }
+
+  {
+    // every winner bit is a public input, so the input accumulation grows
+    ZKSystem system;
+    std::vector<BitArray> bids;
+    for (size_t i = 0; i < 64; i++) {
+      bids.emplace_back(system, "bid" + std::to_string(i), 32);
+    }
+    UniformPriceAuction auction(bids, 8);
+    for (FieldElem *winner : auction.winners) {
+      winner->make_public();
+    }
+    auction.price->make_public();
+    system.compile();
+
+    bench("uniform price, 64 bids, 8 winners", system, bids, rounds);
+  }
+
+  return 0;
+}
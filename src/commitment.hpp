@@ -0,0 +1,46 @@
+#ifndef COMMITMENT_HPP_
+#define COMMITMENT_HPP_
+
+#include <string>
+
+#include "zksystem.hpp"
+#include "mimc.hpp"
+
+// A bidder commits to a bid with mimc_compress(bid, nonce), the nonce
+// being a uniformly random field element they keep until the auction is
+// opened. The nonce makes the commitment hiding, and opening it to a
+// different bid takes a MiMC collision. About 365 constraints per bid
+// against 27k for SHA-256, so 1000 committed bids stay under 400k.
+struct BidCommitment {
+    LeafFieldElem &nonce;
+    FieldElem &value;
+
+    BidCommitment(BitArray &bid, const std::string &name) :
+        nonce(bid.system.def(name + "_nonce")),
+        value(mimc_compress(bid.to_field_elem(), nonce)) {}
+
+    void set_nonce(const FieldT &x) {
+        nonce.set(x);
+    }
+
+    FieldT eval() {
+        return value.eval();
+    }
+};
+
+// the same commitment outside the circuit, for bidders to publish theirs
+inline FieldT commit_bid(unsigned long long bid, const FieldT &nonce) {
+    // FieldT only takes a signed long
+    const FieldT value = FieldT((long) (bid >> 32)) * FieldT(1L << 32) + FieldT((long) (bid & 0xffffffffULL));
+    return mimc_compress(value, nonce);
+}
+
+inline FieldT commit_bid(const FieldT &bid, const FieldT &nonce) {
+    return mimc_compress(bid, nonce);
+}
+
+inline FieldT random_nonce() {
+    return FieldT::random_element();
+}
+
+#endif // COMMITMENT_HPP_
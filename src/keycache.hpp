@@ -0,0 +1,176 @@
+#ifndef KEYCACHE_HPP_
+#define KEYCACHE_HPP_
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <streambuf>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "zksystem.hpp"
+
+// FNV-1a over the shape of a constraint system: input sizes, then every
+// constraint's three linear combinations with their terms merged and
+// sorted by variable. Annotations don't count, so debug and release
+// builds of the same circuit share keys.
+struct CircuitHash {
+    uint64_t h;
+
+    CircuitHash() : h(0xcbf29ce484222325ULL) {}
+
+    void add(uint64_t x) {
+        for (int i = 0; i < 8; i++) {
+            h ^= (x >> (8 * i)) & 0xff;
+            h *= 0x100000001b3ULL;
+        }
+    }
+
+    void add(const FieldT &x) {
+        const auto bigint = x.as_bigint();
+        for (size_t i = 0; i < FieldT::num_limbs; i++) {
+            add((uint64_t) bigint.data[i]);
+        }
+    }
+
+    void add(const linear_combination<FieldT> &expr) {
+        const linear_combination<FieldT> canonical = compact(expr);
+        add(canonical.terms.size());
+        for (const auto &term : canonical.terms) {
+            add(term.index);
+            add(term.coeff);
+        }
+    }
+};
+
+inline uint64_t circuit_hash(const r1cs_constraint_system<FieldT> &constraint_system) {
+    CircuitHash hash;
+    // the field itself, so that keys for another curve never match
+    hash.add(-FieldT::one());
+    hash.add(constraint_system.primary_input_size);
+    hash.add(constraint_system.auxiliary_input_size);
+    hash.add(constraint_system.constraints.size());
+    for (const auto &constraint : constraint_system.constraints) {
+        hash.add(constraint.a);
+        hash.add(constraint.b);
+        hash.add(constraint.c);
+    }
+    return hash.h;
+}
+
+// streams straight out of a mapped file, without copying it into a buffer
+struct MemoryStreamBuf : public std::streambuf {
+    MemoryStreamBuf(char *data, size_t size) {
+        setg(data, data, data + size);
+    }
+};
+
+// Read-only mapping of a whole file; data is null if it couldn't be
+// opened or mapped.
+struct MappedFile {
+    char *data;
+    size_t size;
+
+    MappedFile(const std::string &path) : data(nullptr), size(0) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *mem = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mem != MAP_FAILED) {
+                madvise(mem, st.st_size, MADV_SEQUENTIAL);
+                data = static_cast<char *>(mem);
+                size = st.st_size;
+            }
+        }
+        close(fd);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+
+    ~MappedFile() {
+        if (data) {
+            munmap(data, size);
+        }
+    }
+};
+
+// Keypairs on disk, one per circuit shape, named after circuit_hash().
+// The proving key is parsed straight out of a memory mapping; with
+// libff's BINARY_OUTPUT and MONTGOMERY_OUTPUT (the libsnark defaults)
+// that is close to a memcpy per point, so a warm start skips the
+// generator entirely.
+struct KeyCache {
+    std::string dir;
+    // whether the last keypair came from disk
+    bool hit;
+
+    KeyCache(std::string _dir) : dir(_dir), hit(false) {}
+
+    std::string path(uint64_t hash, const char *ext) const {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx", (unsigned long long) hash);
+        return dir + "/" + name + ext;
+    }
+
+    KeyPair get(ZKSystem &system) {
+        const r1cs_constraint_system<FieldT> constraint_system = system.pb.get_constraint_system();
+        const uint64_t hash = circuit_hash(constraint_system);
+
+        // libsnark's keypair can be copied and moved but not assigned,
+        // so each path returns its own
+        KeyPair loaded;
+        hit = load(hash, loaded) && loaded.pk.constraint_system == constraint_system;
+        if (hit) {
+            return loaded;
+        }
+        KeyPair generated = r1cs_ppzksnark_generator<default_r1cs_ppzksnark_pp>(constraint_system);
+        store(hash, generated);
+        return generated;
+    }
+
+    // the verification key comes first: it's small, and the proving key
+    // after it can then be parsed straight out of the mapping
+    bool load(uint64_t hash, KeyPair &keypair) const {
+        MappedFile file(path(hash, ".keys"));
+        if (!file.data) {
+            return false;
+        }
+
+        MemoryStreamBuf buf(file.data, file.size);
+        std::istream in(&buf);
+        in >> keypair.vk;
+        in >> keypair.pk;
+        return !in.fail();
+    }
+
+    // Both keys go into one temporary file, which is then renamed: a
+    // crash never leaves a truncated key under the real name, and two
+    // runs generating keys for the same circuit at once can't leave one
+    // run's verification key next to the other's proving key.
+    void store(uint64_t hash, const KeyPair &keypair) const {
+        if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+            std::cout << "Can't create key cache " << dir << std::endl;
+            return;
+        }
+        const std::string target = path(hash, ".keys");
+        const std::string tmp = target + ".tmp" + std::to_string(getpid());
+        std::ofstream out(tmp, std::ios::binary);
+        out << keypair.vk;
+        out << keypair.pk;
+        out.close();
+        if (!out || std::rename(tmp.c_str(), target.c_str()) != 0) {
+            std::cout << "Can't write " << target << std::endl;
+            std::remove(tmp.c_str());
+        }
+    }
+};
+
+#endif // KEYCACHE_HPP_
@@ -0,0 +1,117 @@
+#ifndef MERKLE_HPP_
+#define MERKLE_HPP_
+
+#include <vector>
+
+#include "zksystem.hpp"
+#include "mimc.hpp"
+
+// Binary Merkle trees hashed with mimc_compress. The leaves are padded
+// with zeros up to a power of two, so the depth only depends on the
+// number of leaves and the circuit and the native tree agree on it.
+
+inline size_t merkle_depth(size_t n_leaves) {
+    size_t depth = 0;
+    while (((size_t) 1 << depth) < n_leaves) {
+        depth += 1;
+    }
+    return depth;
+}
+
+// Commits to every bid commitment (or any other private leaves) with a
+// single public root: the verifier then pays for one input however many
+// bidders there are. At most n - 1 + depth compressions, at 364
+// constraints each: subtrees of padding alone are constants and cost
+// nothing.
+struct MerkleRoot {
+    FieldElem *root;
+    size_t depth;
+
+    MerkleRoot(const std::vector<FieldElem *> &leaves) : depth(merkle_depth(leaves.size())) {
+        if (leaves.empty()) {
+            std::cout << "A Merkle tree needs at least one leaf" << std::endl;
+            throw 1;
+        }
+        ZKSystem &system = leaves[0]->system;
+        std::vector<FieldElem *> level(leaves);
+        level.resize((size_t) 1 << depth, &system.constant(0L));
+        while (level.size() > 1) {
+            std::vector<FieldElem *> next;
+            for (size_t i = 0; i < level.size(); i += 2) {
+                next.push_back(&mimc_compress(*level[i], *level[i + 1]));
+            }
+            level.swap(next);
+        }
+        root = level[0];
+    }
+
+    void make_public() {
+        root->make_public();
+    }
+};
+
+// sibling hashes from a leaf up to the root; bit j of index says whether
+// the node at height j is a right child
+struct MerklePath {
+    size_t index;
+    std::vector<FieldT> siblings;
+};
+
+// The same tree outside the circuit, for the auctioneer to publish the
+// root and hand each bidder the path proving their commitment is in it.
+struct MerkleTree {
+    // levels[0] holds the padded leaves, levels.back() the root
+    std::vector<std::vector<FieldT> > levels;
+
+    MerkleTree(const std::vector<FieldT> &leaves) {
+        if (leaves.empty()) {
+            std::cout << "A Merkle tree needs at least one leaf" << std::endl;
+            throw 1;
+        }
+        levels.push_back(leaves);
+        levels[0].resize((size_t) 1 << merkle_depth(leaves.size()), FieldT::zero());
+        while (levels.back().size() > 1) {
+            const std::vector<FieldT> &level = levels.back();
+            std::vector<FieldT> next;
+            for (size_t i = 0; i < level.size(); i += 2) {
+                next.push_back(mimc_compress(level[i], level[i + 1]));
+            }
+            levels.push_back(next);
+        }
+    }
+
+    const FieldT & root() const {
+        return levels.back()[0];
+    }
+
+    size_t depth() const {
+        return levels.size() - 1;
+    }
+
+    MerklePath path(size_t index) const {
+        if (index >= levels[0].size()) {
+            std::cout << "No leaf " << index << " in a tree of " << levels[0].size() << std::endl;
+            throw 1;
+        }
+        MerklePath path{index, {}};
+        for (size_t height = 0; height < depth(); height++) {
+            path.siblings.push_back(levels[height][(index >> height) ^ 1]);
+        }
+        return path;
+    }
+};
+
+// what a bidder checks against the published root
+inline bool verify_merkle_path(const FieldT &root, const FieldT &leaf, const MerklePath &path) {
+    FieldT node = leaf;
+    for (size_t height = 0; height < path.siblings.size(); height++) {
+        if ((path.index >> height) & 1) {
+            node = mimc_compress(path.siblings[height], node);
+        } else {
+            node = mimc_compress(node, path.siblings[height]);
+        }
+    }
+    return node == root;
+}
+
+#endif // MERKLE_HPP_
@@ -0,0 +1,89 @@
+#ifndef MIMC_HPP_
+#define MIMC_HPP_
+
+#include <vector>
+
+#include "zksystem.hpp"
+
+// MiMC-7 over FieldT (Albrecht et al., "MiMC: Efficient Encryption and
+// Cryptographic Hashing with Minimal Multiplicative Complexity"): each
+// round maps x to (x + k + c_i)^7, and the last round adds k once more.
+// x^7 is a permutation because 7 doesn't divide r - 1 for the scalar
+// field shared by alt_bn128 and bn128, and 91 rounds (log_7 r rounded
+// up) cover the 254-bit field. Four products per round, so a
+// permutation costs 364 constraints, where a bitwise SHA-256 costs about
+// 27k.
+//
+// On EDWARDS, MNT4 and MNT6, 7 divides r - 1, so x^7 isn't a
+// permutation and the commitments and Merkle roots built on it would
+// stop being injective.
+#if !defined(CURVE_ALT_BN128) && !defined(CURVE_BN128)
+#error "MiMC-7 needs gcd(7, r - 1) = 1, which only holds on ALT_BN128 and BN128"
+#endif
+
+const size_t MIMC_ROUNDS = 91;
+
+// Round constants are fixed and public: the field elements drawn from a
+// splitmix64 stream with a fixed seed, 32 bits at a time.
+inline std::vector<FieldT> make_mimc_constants() {
+    // native hashing may come before any ZKSystem has set up the field
+    default_r1cs_ppzksnark_pp::init_public_params();
+    std::vector<FieldT> constants;
+    unsigned long long state = 0x4d694d4337ULL;  // "MiMC7"
+    for (size_t i = 0; i < MIMC_ROUNDS; i++) {
+        FieldT c = FieldT::zero();
+        for (size_t limb = 0; limb < 8; limb++) {
+            unsigned long long z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            z = z ^ (z >> 31);
+            c = c * FieldT(1L << 32) + FieldT((long) (z >> 32));
+        }
+        constants.push_back(c);
+    }
+    return constants;
+}
+
+// built once, on first use, whichever thread gets there first
+inline const std::vector<FieldT> & mimc_constants() {
+    static const std::vector<FieldT> constants = make_mimc_constants();
+    return constants;
+}
+
+// E_k(x), for witnesses and for anyone checking a hash outside the circuit
+inline FieldT mimc_encrypt(const FieldT &x, const FieldT &k) {
+    const std::vector<FieldT> &constants = mimc_constants();
+    FieldT y = x;
+    for (size_t i = 0; i < MIMC_ROUNDS; i++) {
+        const FieldT t = y + k + constants[i];
+        const FieldT t2 = t * t;
+        const FieldT t4 = t2 * t2;
+        y = t4 * t2 * t;
+    }
+    return y + k;
+}
+
+inline FieldElem & mimc_encrypt(FieldElem &x, FieldElem &k) {
+    ZKSystem &system = x.system;
+    const std::vector<FieldT> &constants = mimc_constants();
+    FieldElem *y = &x;
+    for (size_t i = 0; i < MIMC_ROUNDS; i++) {
+        FieldElem &t = *y + k + system.constant(constants[i]);
+        FieldElem &t2 = t * t;
+        FieldElem &t4 = t2 * t2;
+        y = &(t4 * t2 * t);
+    }
+    return *y + k;
+}
+
+// Miyaguchi-Preneel: E_l(r) + l + r, a two-to-one compression that is
+// hard to invert even though E is a permutation for every key
+inline FieldT mimc_compress(const FieldT &l, const FieldT &r) {
+    return mimc_encrypt(r, l) + l + r;
+}
+
+inline FieldElem & mimc_compress(FieldElem &l, FieldElem &r) {
+    return mimc_encrypt(r, l) + l + r;
+}
+
+#endif // MIMC_HPP_
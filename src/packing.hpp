@@ -0,0 +1,75 @@
+#ifndef PACKING_HPP_
+#define PACKING_HPP_
+
+#include <vector>
+
+#include "zksystem.hpp"
+
+// Public bits cost the verifier one IC point (and the Solidity verifier
+// one scalar multiplication) each. Packing them into field elements of
+// FieldT::capacity() bits cuts that by a factor of about 250 on
+// alt_bn128. Each packed element is one public variable tied to its bits
+// by one constraint, and since the bits are boolean and fewer than the
+// field's size the packing can't be opened to any other bits.
+//
+// The layout is libff's pack_bit_vector_into_field_element_vector: the
+// bits of all arrays are concatenated in order (each array most
+// significant bit first, as BitArray keeps them), cut into chunks of
+// capacity() bits, and bit i of a chunk has weight 2^i.
+struct PackedPublicInputs {
+    ZKSystem &system;
+    std::vector<FieldElem *> bits;
+    std::vector<FieldElem *> packed;
+
+    PackedPublicInputs(ZKSystem &_system, const std::vector<BitArray *> &arrays) : system(_system) {
+        for (BitArray *array : arrays) {
+            bits.insert(bits.end(), array->bits.begin(), array->bits.end());
+        }
+
+        const size_t chunk_bits = FieldT::capacity();
+        for (size_t begin = 0; begin < bits.size(); begin += chunk_bits) {
+            const size_t end = std::min(bits.size(), begin + chunk_bits);
+            // PackedFieldElem weighs its first input highest
+            std::vector<FieldElem *> chunk(bits.rend() - end, bits.rend() - begin);
+            packed.push_back(&system.pack(chunk));
+            packed.back()->make_public();
+        }
+    }
+
+    std::vector<FieldT> eval() {
+        std::vector<FieldT> values;
+        for (FieldElem *elem : packed) {
+            values.push_back(elem->eval());
+        }
+        return values;
+    }
+};
+
+// The bits of x, most significant first like a BitArray of width bits.
+inline libff::bit_vector to_bits(unsigned long long x, size_t width) {
+    libff::bit_vector bits;
+    for (size_t i = 0; i < width; i++) {
+        const size_t shift = width - 1 - i;
+        bits.push_back(shift < 64 && ((x >> shift) & 1));
+    }
+    return bits;
+}
+
+// What a verifier computes from the public bit values it expects, to use
+// in place of the bits in the primary input.
+inline std::vector<FieldT> pack_public_bits(const libff::bit_vector &bits) {
+    return libff::pack_bit_vector_into_field_element_vector<FieldT>(bits, FieldT::capacity());
+}
+
+// The inverse, for reading n_bits public bits out of a primary input.
+inline libff::bit_vector unpack_public_bits(const std::vector<FieldT> &packed, size_t n_bits) {
+    const size_t chunk_bits = FieldT::capacity();
+    libff::bit_vector bits;
+    for (size_t i = 0; i < n_bits; i++) {
+        const size_t chunk = i / chunk_bits;
+        bits.push_back(chunk < packed.size() && packed[chunk].as_bigint().test_bit(i % chunk_bits));
+    }
+    return bits;
+}
+
+#endif // PACKING_HPP_
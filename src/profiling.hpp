@@ -0,0 +1,27 @@
+#ifndef PROFILING_HPP_
+#define PROFILING_HPP_
+
+#include "libff/common/profiling.hpp"
+
+// libff's enter_block and leave_block update global maps of timings and
+// counters without a lock, so provers or verifiers running on several
+// threads at once race on them. Both return straight away once
+// inhibit_profiling_counters is set; this turns profiling off for as
+// long as it is in scope and puts the caller's settings back after.
+struct ProfilingOff {
+    bool info, counters;
+
+    ProfilingOff() : info(libff::inhibit_profiling_info), counters(libff::inhibit_profiling_counters) {
+        libff::inhibit_profiling_info = libff::inhibit_profiling_counters = true;
+    }
+
+    ProfilingOff(const ProfilingOff &) = delete;
+    ProfilingOff & operator=(const ProfilingOff &) = delete;
+
+    ~ProfilingOff() {
+        libff::inhibit_profiling_info = info;
+        libff::inhibit_profiling_counters = counters;
+    }
+};
+
+#endif // PROFILING_HPP_
@@ -0,0 +1,389 @@
+#ifndef SERIALIZE_HPP_
+#define SERIALIZE_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "libff/algebra/scalar_multiplication/multiexp.hpp"
+#include "libsnark/zk_proof_systems/ppzksnark/r1cs_ppzksnark/r1cs_ppzksnark.hpp"
+#ifdef CURVE_ALT_BN128
+#include "libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp"
+#endif
+
+// Binary proofs and verification keys. Everything is big-endian:
+//
+//   "ZKSN"  magic
+//   u8      SERIAL_VERSION
+//   u8      SERIAL_PROOF or SERIAL_VERIFICATION_KEY
+//   u8      curve id, see CurveTraits
+//   u8      0, reserved
+//
+// followed by the points, compressed to their x coordinate. The top two
+// bits of a point's first byte are free on the supported curves and
+// flag the point at infinity and the parity of y. G2 coordinates are
+// written c1 first, as Ethereum's precompiles expect them.
+//
+//   proof  A, A', B (G2), B', C, C', H, K
+//   key    alphaA (G2), alphaB, alphaC (G2), gamma (G2), gamma_beta_g1,
+//          gamma_beta_g2 (G2), rC_Z (G2), u32 input count n, IC_0 ... IC_n
+//
+// On alt_bn128 that is 296 bytes per proof, against about 1.3 KB of
+// decimal text from print_proof_to_file, and 396 bytes plus 32 per IC
+// point (n + 1 of them) per key.
+
+const uint8_t SERIAL_VERSION = 1;
+const uint8_t SERIAL_PROOF = 1;
+const uint8_t SERIAL_VERIFICATION_KEY = 2;
+
+// What point compression needs to know about a curve: its coordinate
+// fields, how they map to bytes, square roots, and the curve equations
+// y^2 = x^3 + b over both fields.
+template<typename ppT>
+struct CurveTraits;
+
+#ifdef CURVE_ALT_BN128
+template<>
+struct CurveTraits<libff::alt_bn128_pp> {
+    typedef libff::alt_bn128_G1 G1;
+    typedef libff::alt_bn128_G2 G2;
+    typedef libff::alt_bn128_Fq Fq;
+    typedef libff::alt_bn128_Fq2 Fq2;
+
+    static const uint8_t id = 1;
+    // 254-bit field, so the top two bits of each coordinate are free
+    static const size_t fq_bytes = 32;
+
+    static Fq g1_b() {
+        return libff::alt_bn128_coeff_b;
+    }
+
+    static Fq2 g2_b() {
+        return libff::alt_bn128_twist_coeff_b;
+    }
+
+    static G1 g1(const Fq &x, const Fq &y) {
+        return G1(x, y, Fq::one());
+    }
+
+    static G2 g2(const Fq2 &x, const Fq2 &y) {
+        return G2(x, y, Fq2::one());
+    }
+
+    // G1 has cofactor 1, but the twist doesn't
+    static bool in_subgroup(const G2 &p) {
+        return (libff::alt_bn128_modulus_r * p).is_zero();
+    }
+
+    static void put(const Fq &x, unsigned char *out) {
+        const auto bigint = x.as_bigint();
+        for (size_t i = 0; i < fq_bytes; i++) {
+            const size_t byte = fq_bytes - 1 - i;
+            out[i] = (bigint.data[byte / sizeof(mp_limb_t)] >> (8 * (byte % sizeof(mp_limb_t)))) & 0xff;
+        }
+    }
+
+    // fails on anything that isn't reduced
+    static bool get(const unsigned char *in, Fq &x) {
+        libff::bigint<Fq::num_limbs> bigint;
+        for (size_t i = 0; i < fq_bytes; i++) {
+            const size_t byte = fq_bytes - 1 - i;
+            bigint.data[byte / sizeof(mp_limb_t)] |= (mp_limb_t) in[i] << (8 * (byte % sizeof(mp_limb_t)));
+        }
+        if (mpn_cmp(bigint.data, Fq::mod.data, Fq::num_limbs) >= 0) {
+            return false;
+        }
+        x = Fq(bigint);
+        return true;
+    }
+
+    static bool is_odd(const Fq &x) {
+        return x.as_bigint().data[0] & 1;
+    }
+
+    // -y flips the parity of every non-zero coordinate, since p is odd
+    static bool is_odd(const Fq2 &x) {
+        return x.c1.is_zero() ? is_odd(x.c0) : is_odd(x.c1);
+    }
+
+    // libff's sqrt() never returns on a non-residue, so check first
+    template<typename F>
+    static bool sqrt(const F &a, F &root) {
+        if (!a.is_zero() && (a ^ F::euler) != F::one()) {
+            return false;
+        }
+        root = a.sqrt();
+        return true;
+    }
+};
+#endif
+
+template<typename ppT>
+struct PointCodec {
+    typedef CurveTraits<ppT> Curve;
+    typedef typename Curve::G1 G1;
+    typedef typename Curve::G2 G2;
+    typedef typename Curve::Fq Fq;
+    typedef typename Curve::Fq2 Fq2;
+
+    static const size_t g1_size = Curve::fq_bytes;
+    static const size_t g2_size = 2 * Curve::fq_bytes;
+
+    static const unsigned char INFINITY_FLAG = 0x80;
+    static const unsigned char ODD_FLAG = 0x40;
+
+    // Points that are already normalised (see normalize()) cost no
+    // inversion here.
+    static void compress(const G1 &p, unsigned char *out) {
+        if (p.is_zero()) {
+            memset(out, 0, g1_size);
+            out[0] = INFINITY_FLAG;
+            return;
+        }
+        if (!p.is_special()) {
+            G1 affine(p);
+            affine.to_affine_coordinates();
+            compress(affine, out);
+            return;
+        }
+        Curve::put(p.X, out);
+        out[0] |= Curve::is_odd(p.Y) ? ODD_FLAG : 0;
+    }
+
+    static void compress(const G2 &p, unsigned char *out) {
+        if (p.is_zero()) {
+            memset(out, 0, g2_size);
+            out[0] = INFINITY_FLAG;
+            return;
+        }
+        if (!p.is_special()) {
+            G2 affine(p);
+            affine.to_affine_coordinates();
+            compress(affine, out);
+            return;
+        }
+        Curve::put(p.X.c1, out);
+        Curve::put(p.X.c0, out + Curve::fq_bytes);
+        out[0] |= Curve::is_odd(p.Y) ? ODD_FLAG : 0;
+    }
+
+    // brings points to Z = 1 with a single inversion for all of them
+    template<typename T>
+    static void normalize(std::vector<T> &points) {
+        libff::batch_to_special<T>(points);
+    }
+
+    // false unless in holds the encoding of a point in the group
+    static bool decompress(const unsigned char *in, G1 &p) {
+        std::vector<unsigned char> x_bytes(in, in + g1_size);
+        const unsigned char flags = x_bytes[0] & (INFINITY_FLAG | ODD_FLAG);
+        x_bytes[0] &= ~(INFINITY_FLAG | ODD_FLAG);
+        if (flags & INFINITY_FLAG) {
+            p = G1::zero();
+            return flags == INFINITY_FLAG && all_zero(x_bytes);
+        }
+
+        Fq x, y;
+        if (!Curve::get(x_bytes.data(), x) || !Curve::sqrt(x.squared() * x + Curve::g1_b(), y)) {
+            return false;
+        }
+        if (Curve::is_odd(y) != bool(flags & ODD_FLAG)) {
+            y = -y;
+        }
+        p = Curve::g1(x, y);
+        return true;
+    }
+
+    static bool decompress(const unsigned char *in, G2 &p) {
+        std::vector<unsigned char> x_bytes(in, in + g2_size);
+        const unsigned char flags = x_bytes[0] & (INFINITY_FLAG | ODD_FLAG);
+        x_bytes[0] &= ~(INFINITY_FLAG | ODD_FLAG);
+        if (flags & INFINITY_FLAG) {
+            p = G2::zero();
+            return flags == INFINITY_FLAG && all_zero(x_bytes);
+        }
+
+        Fq2 x, y;
+        if (!Curve::get(x_bytes.data(), x.c1) || !Curve::get(x_bytes.data() + Curve::fq_bytes, x.c0) ||
+            !Curve::sqrt(x.squared() * x + Curve::g2_b(), y)) {
+            return false;
+        }
+        if (Curve::is_odd(y) != bool(flags & ODD_FLAG)) {
+            y = -y;
+        }
+        p = Curve::g2(x, y);
+        return Curve::in_subgroup(p);
+    }
+
+    static bool all_zero(const std::vector<unsigned char> &bytes) {
+        for (unsigned char byte : bytes) {
+            if (byte) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Writes each point straight to the stream as it comes, so a key is never
+// serialised into memory as a whole.
+template<typename ppT>
+struct SerialWriter {
+    typedef PointCodec<ppT> Codec;
+
+    std::ostream &out;
+
+    SerialWriter(std::ostream &_out, uint8_t kind) : out(_out) {
+        const unsigned char header[8] = {'Z', 'K', 'S', 'N', SERIAL_VERSION, kind, CurveTraits<ppT>::id, 0};
+        out.write(reinterpret_cast<const char *>(header), sizeof(header));
+    }
+
+    void u32(uint32_t x) {
+        const unsigned char bytes[4] = {(unsigned char) (x >> 24), (unsigned char) (x >> 16), (unsigned char) (x >> 8), (unsigned char) x};
+        out.write(reinterpret_cast<const char *>(bytes), sizeof(bytes));
+    }
+
+    void g1(const typename Codec::G1 &p) {
+        unsigned char bytes[Codec::g1_size];
+        Codec::compress(p, bytes);
+        out.write(reinterpret_cast<const char *>(bytes), sizeof(bytes));
+    }
+
+    void g2(const typename Codec::G2 &p) {
+        unsigned char bytes[Codec::g2_size];
+        Codec::compress(p, bytes);
+        out.write(reinterpret_cast<const char *>(bytes), sizeof(bytes));
+    }
+};
+
+// The reading side; ok turns false at the first short read or bad point
+// and stays false.
+template<typename ppT>
+struct SerialReader {
+    typedef PointCodec<ppT> Codec;
+
+    std::istream &in;
+    bool ok;
+
+    SerialReader(std::istream &_in, uint8_t kind) : in(_in), ok(true) {
+        unsigned char header[8];
+        ok = read(header, sizeof(header)) && memcmp(header, "ZKSN", 4) == 0 && header[4] == SERIAL_VERSION &&
+            header[5] == kind && header[6] == CurveTraits<ppT>::id;
+    }
+
+    bool read(unsigned char *bytes, size_t size) {
+        in.read(reinterpret_cast<char *>(bytes), size);
+        return in.gcount() == (std::streamsize) size;
+    }
+
+    uint32_t u32() {
+        unsigned char bytes[4];
+        ok = ok && read(bytes, sizeof(bytes));
+        return ok ? (uint32_t) bytes[0] << 24 | (uint32_t) bytes[1] << 16 | (uint32_t) bytes[2] << 8 | bytes[3] : 0;
+    }
+
+    typename Codec::G1 g1() {
+        unsigned char bytes[Codec::g1_size];
+        typename Codec::G1 p = Codec::G1::zero();
+        ok = ok && read(bytes, sizeof(bytes)) && Codec::decompress(bytes, p);
+        return p;
+    }
+
+    typename Codec::G2 g2() {
+        unsigned char bytes[Codec::g2_size];
+        typename Codec::G2 p = Codec::G2::zero();
+        ok = ok && read(bytes, sizeof(bytes)) && Codec::decompress(bytes, p);
+        return p;
+    }
+};
+
+template<typename ppT>
+void write_proof(std::ostream &out, const r1cs_ppzksnark_proof<ppT> &proof) {
+    std::vector<libff::G1<ppT> > g1 = {proof.g_A.g, proof.g_A.h, proof.g_B.h, proof.g_C.g, proof.g_C.h, proof.g_H, proof.g_K};
+    PointCodec<ppT>::normalize(g1);
+
+    SerialWriter<ppT> writer(out, SERIAL_PROOF);
+    writer.g1(g1[0]);
+    writer.g1(g1[1]);
+    writer.g2(proof.g_B.g);
+    for (size_t i = 2; i < g1.size(); i++) {
+        writer.g1(g1[i]);
+    }
+}
+
+template<typename ppT>
+bool read_proof(std::istream &in, r1cs_ppzksnark_proof<ppT> &proof) {
+    SerialReader<ppT> reader(in, SERIAL_PROOF);
+    proof.g_A.g = reader.g1();
+    proof.g_A.h = reader.g1();
+    proof.g_B.g = reader.g2();
+    proof.g_B.h = reader.g1();
+    proof.g_C.g = reader.g1();
+    proof.g_C.h = reader.g1();
+    proof.g_H = reader.g1();
+    proof.g_K = reader.g1();
+    return reader.ok;
+}
+
+// IC points are normalised and written this many at a time, which keeps
+// the inversions batched without copying the whole query
+const size_t SERIAL_CHUNK = 1024;
+
+template<typename ppT>
+void write_verification_key(std::ostream &out, const r1cs_ppzksnark_verification_key<ppT> &vk) {
+    typedef PointCodec<ppT> Codec;
+
+    std::vector<libff::G2<ppT> > g2 = {vk.alphaA_g2, vk.alphaC_g2, vk.gamma_g2, vk.gamma_beta_g2, vk.rC_Z_g2};
+    std::vector<libff::G1<ppT> > g1 = {vk.alphaB_g1, vk.gamma_beta_g1, vk.encoded_IC_query.first};
+    Codec::normalize(g2);
+    Codec::normalize(g1);
+
+    SerialWriter<ppT> writer(out, SERIAL_VERIFICATION_KEY);
+    writer.g2(g2[0]);
+    writer.g1(g1[0]);
+    writer.g2(g2[1]);
+    writer.g2(g2[2]);
+    writer.g1(g1[1]);
+    writer.g2(g2[3]);
+    writer.g2(g2[4]);
+
+    const size_t n_inputs = vk.encoded_IC_query.domain_size();
+    writer.u32(n_inputs);
+    writer.g1(g1[2]);
+    std::vector<libff::G1<ppT> > chunk;
+    for (size_t begin = 0; begin < n_inputs; begin += SERIAL_CHUNK) {
+        chunk.clear();
+        for (size_t i = begin; i < std::min(n_inputs, begin + SERIAL_CHUNK); i++) {
+            chunk.push_back(vk.encoded_IC_query.rest[i]);
+        }
+        Codec::normalize(chunk);
+        for (const auto &p : chunk) {
+            writer.g1(p);
+        }
+    }
+}
+
+template<typename ppT>
+bool read_verification_key(std::istream &in, r1cs_ppzksnark_verification_key<ppT> &vk) {
+    SerialReader<ppT> reader(in, SERIAL_VERIFICATION_KEY);
+    vk.alphaA_g2 = reader.g2();
+    vk.alphaB_g1 = reader.g1();
+    vk.alphaC_g2 = reader.g2();
+    vk.gamma_g2 = reader.g2();
+    vk.gamma_beta_g1 = reader.g1();
+    vk.gamma_beta_g2 = reader.g2();
+    vk.rC_Z_g2 = reader.g2();
+
+    const size_t n_inputs = reader.u32();
+    libff::G1<ppT> first = reader.g1();
+    std::vector<libff::G1<ppT> > rest;
+    for (size_t i = 0; i < n_inputs && reader.ok; i++) {
+        rest.push_back(reader.g1());
+    }
+    vk.encoded_IC_query = accumulation_vector<libff::G1<ppT> >(std::move(first), std::move(rest));
+    return reader.ok;
+}
+
+#endif // SERIALIZE_HPP_
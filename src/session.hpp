@@ -0,0 +1,80 @@
+#ifndef SESSION_HPP_
+#define SESSION_HPP_
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "zksystem.hpp"
+
+// Peak resident set size of this process in kB (VmHWM), or 0 where
+// /proc isn't available.
+inline size_t peak_rss_kb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::stoul(line.substr(6));
+        }
+    }
+    return 0;
+}
+
+// Starts a new peak at the current RSS, so that the next peak_rss_kb()
+// covers only what ran in between. Needs Linux 4.0 or later; returns
+// false when the peak can't be reset.
+inline bool reset_peak_rss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.close();
+    return !clear_refs.fail();
+}
+
+// Holds one circuit's keys for as long as it serves proofs, so that each
+// prove or verify call works on the resident keys instead of a copy.
+// The keys are shared, so sessions (and threads) can share them too. The
+// verification key is processed once, up front, for the online verifier.
+struct ProverSession {
+    std::shared_ptr<const ProvingKey> pk;
+    std::shared_ptr<const VerificationKey> vk;
+    std::shared_ptr<const ProcessedVerificationKey> pvk;
+
+    // peak RSS during the last call in kB; if the peak couldn't be reset
+    // it's the process-wide peak instead
+    size_t last_peak_kb;
+    bool peak_per_call;
+
+    ProverSession(KeyPair &&keypair) :
+        pk(std::make_shared<const ProvingKey>(std::move(keypair.pk))),
+        vk(std::make_shared<const VerificationKey>(std::move(keypair.vk))),
+        pvk(std::make_shared<const ProcessedVerificationKey>(r1cs_ppzksnark_verifier_process_vk<default_r1cs_ppzksnark_pp>(*vk))),
+        last_peak_kb(0), peak_per_call(false) {}
+
+    ProverSession(std::shared_ptr<const ProvingKey> _pk, std::shared_ptr<const VerificationKey> _vk) :
+        pk(_pk), vk(_vk),
+        pvk(std::make_shared<const ProcessedVerificationKey>(r1cs_ppzksnark_verifier_process_vk<default_r1cs_ppzksnark_pp>(*vk))),
+        last_peak_kb(0), peak_per_call(false) {}
+
+    Proof prove(ZKSystem &system) {
+        peak_per_call = reset_peak_rss();
+        Proof proof = system.make_proof(*pk);
+        last_peak_kb = peak_rss_kb();
+        return proof;
+    }
+
+    bool verify(ZKSystem &system, const Proof &proof) {
+        peak_per_call = reset_peak_rss();
+        bool verified = system.verify_proof(*pvk, proof);
+        last_peak_kb = peak_rss_kb();
+        return verified;
+    }
+
+    bool verify(const r1cs_primary_input<FieldT> &primary_input, const Proof &proof) {
+        peak_per_call = reset_peak_rss();
+        bool verified = r1cs_ppzksnark_online_verifier_strong_IC<default_r1cs_ppzksnark_pp>(*pvk, primary_input, proof);
+        last_peak_kb = peak_rss_kb();
+        return verified;
+    }
+};
+
+#endif // SESSION_HPP_
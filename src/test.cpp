@@ -1,376 +1,19 @@
 #include <stdlib.h>
+#include <algorithm>
 #include <iostream>
-
-#include "libff/algebra/fields/field_utils.hpp"
-#include "libsnark/zk_proof_systems/ppzksnark/r1cs_ppzksnark/r1cs_ppzksnark.hpp"
-#include "libsnark/common/default_types/r1cs_ppzksnark_pp.hpp"
-#include "libsnark/gadgetlib1/pb_variable.hpp"
-
+#include <sstream>
+
+#include "zksystem.hpp"
+#include "auction.hpp"
+#include "batchprover.hpp"
+#include "commitment.hpp"
+#include "keycache.hpp"
+#include "merkle.hpp"
+#include "packing.hpp"
+#include "serialize.hpp"
+#include "session.hpp"
 #include "util.hpp"
-
-using namespace libsnark;
-using namespace std;
-
-typedef libff::Fr<default_r1cs_ppzksnark_pp> FieldT;
-typedef r1cs_ppzksnark_keypair<default_r1cs_ppzksnark_pp> KeyPair;
-typedef r1cs_ppzksnark_proof<default_r1cs_ppzksnark_pp> Proof;
-
-struct ZKSystem;
-struct SumFieldElem;
-struct DiffFieldElem;
-struct ProdFieldElem;
-
-struct FieldElem {
-    ZKSystem &system;
-    pb_variable<FieldT> pb_var;
-    std::string name;
-    bool pub, is_set;
-    int val;
-
-    FieldElem(std::string _name, ZKSystem &_system);
-
-    virtual void set(int x) {
-        std::cout << "Can't set the value of a non-leaf element" << std::endl;
-        throw 1;
-    }
-    void make_public() {
-        pub = true;
-        /* cout << name << " public: " << pub << endl; */
-    }
-
-    virtual int eval() {
-        cout << "field eval" << endl;
-    };
-
-    friend SumFieldElem & operator+(FieldElem &elem1, FieldElem &elem2);
-    friend DiffFieldElem & operator-(FieldElem &elem1, FieldElem &elem2);
-    friend ProdFieldElem & operator*(FieldElem &elem1, FieldElem &elem2);
-
-    friend SumFieldElem & operator+(int x, FieldElem &elem);
-    friend DiffFieldElem & operator-(int x, FieldElem &elem);
-    friend ProdFieldElem & operator*(int x, FieldElem &elem);
-
-    friend SumFieldElem & operator+(FieldElem &elem, int x);
-    friend DiffFieldElem & operator-(FieldElem &elem, int x);
-    friend ProdFieldElem & operator*(FieldElem &elem, int x);
-};
-
-struct LeafFieldElem : public FieldElem {
-    LeafFieldElem(std::string _name, ZKSystem &_system);
-
-    virtual void set(int x) {
-        /* cout << "setting " << name << " to " << x << endl; */
-        is_set = true;
-        val = x;
-    }
-
-    virtual int eval();
-};
-
-struct SumFieldElem : public FieldElem {
-    FieldElem &child_a, &child_b;
-
-    SumFieldElem(FieldElem &elem1, FieldElem &elem2, ZKSystem &_system);
-
-    virtual int eval();
-};
-
-struct DiffFieldElem : public FieldElem {
-    FieldElem &child_a, &child_b;
-
-    DiffFieldElem(FieldElem &elem1, FieldElem &elem2, ZKSystem &_system);
-
-    virtual int eval();
-};
-
-struct ProdFieldElem : public FieldElem {
-    FieldElem &child_a, &child_b;
-
-    ProdFieldElem(FieldElem &elem1, FieldElem &elem2, ZKSystem &_system);
-
-    virtual int eval();
-};
-
-struct ZKSystem {
-    protoboard<FieldT> pb;
-    std::vector<FieldElem *> elems;
-
-    ZKSystem() {
-      default_r1cs_ppzksnark_pp::init_public_params();
-    }
-  
-    const KeyPair make_keypair() {
-      const r1cs_constraint_system<FieldT> constraint_system = pb.get_constraint_system();
-      return r1cs_ppzksnark_generator<default_r1cs_ppzksnark_pp>(constraint_system);
-    }
-
-    const Proof make_proof(KeyPair keypair) {
-        return r1cs_ppzksnark_prover<default_r1cs_ppzksnark_pp>(keypair.pk, pb.primary_input(), pb.auxiliary_input());
-    }
-
-    bool verify_proof(KeyPair keypair, Proof proof) {
-        return r1cs_ppzksnark_verifier_strong_IC<default_r1cs_ppzksnark_pp>(keypair.vk, pb.primary_input(), proof);
-    }
-
-    LeafFieldElem & def(std::string name) {
-        LeafFieldElem *elem = new LeafFieldElem(name, *this);
-        register_elem(elem);
-        return *elem;
-    }
-
-    void register_elem(FieldElem *elem) {
-        elems.push_back(elem);
-    }
-
-    void allocate() {
-        int n_pub = 0;
-        for (FieldElem *elem : elems) {
-            if (elem->pub) {
-                /* cout << "allocating public elem " << elem->name << endl; */
-                n_pub += 1;
-                elem->pb_var.allocate(pb, elem->name);
-            }
-        }
-
-        for (FieldElem *elem : elems) {
-            if (!elem->pub) {
-                /* cout << "allocating private elem " << elem->name << endl; */
-                elem->pb_var.allocate(pb, elem->name);
-            }
-        }
-
-        pb.set_input_sizes(n_pub);
-    }
-
-    ~ZKSystem() {
-        for (FieldElem *elem : elems) {
-            delete elem;
-        }
-    }
-
-};
-
-FieldElem::FieldElem(std::string _name, ZKSystem &_system) : name(_name), system(_system), pub(false), is_set(false), val(0) {
-    /* std::cout << "creating elem " << name << std::endl; */
-};
-
-SumFieldElem & operator+(FieldElem &elem1, FieldElem &elem2) {
-    auto elem = new SumFieldElem(elem1, elem2, elem1.system);
-    elem1.system.register_elem(elem);
-    return *elem;
-}
-
-DiffFieldElem & operator-(FieldElem &elem1, FieldElem &elem2) {
-    auto elem = new DiffFieldElem(elem1, elem2, elem1.system);
-    elem1.system.register_elem(elem);
-    return *elem;
-}
-
-ProdFieldElem & operator*(FieldElem &elem1, FieldElem &elem2) {
-    auto elem = new ProdFieldElem(elem1, elem2, elem1.system);
-    elem1.system.register_elem(elem);
-    return *elem;
-}
-
-SumFieldElem & operator+(int x, FieldElem &elem) {
-    std::string name = std::to_string(x);
-    auto &constant = elem.system.def(name);
-    constant.set(x);
-    auto &ret = constant + elem;
-    return ret;
-}
-
-DiffFieldElem & operator-(int x, FieldElem &elem) {
-    std::string name = std::to_string(x);
-    auto &constant = elem.system.def(name);
-    constant.set(x);
-    auto &ret = constant - elem;  // why is this needed to prevent a copy
-    return ret;
-}
-
-ProdFieldElem & operator*(int x, FieldElem &elem) {
-    std::string name = std::to_string(x);
-    auto &constant = elem.system.def(name);
-    constant.set(x);
-    auto &ret = constant * elem;
-    return ret;
-}
-
-SumFieldElem & operator+(FieldElem &elem, int x) {
-    std::string name = std::to_string(x);
-    auto &constant = elem.system.def(name);
-    constant.set(x);
-    auto &ret = elem + constant;
-    return ret;
-}
-
-DiffFieldElem & operator-(FieldElem &elem, int x) {
-    std::string name = std::to_string(x);
-    auto &constant = elem.system.def(name);
-    constant.set(x);
-    auto &ret = elem - constant;
-    return ret;
-}
-
-ProdFieldElem & operator*(FieldElem &elem, int x) {
-    std::string name = std::to_string(x);
-    auto &constant = elem.system.def(name);
-    constant.set(x);
-    auto &ret = elem * constant;
-    return ret;
-}
-
-LeafFieldElem::LeafFieldElem(std::string _name, ZKSystem &_system) : FieldElem(_name, _system) {};
-
-int LeafFieldElem::eval() {
-    if (!is_set) {
-        cout << "can't eval leaf element without a value" << endl;
-        throw 1;
-    }
-    system.pb.val(pb_var) = val;
-    return val;
-}
-
-SumFieldElem::SumFieldElem(FieldElem &elem1, FieldElem &elem2, ZKSystem &_system) :
-    child_a(elem1), child_b(elem2), FieldElem("(" + elem1.name + "+" + elem2.name + ")", _system) {};
-
-int SumFieldElem::eval() {
-    if (!is_set) {
-        val = child_a.eval() + child_b.eval();
-        system.pb.val(pb_var) = val;
-        is_set = true;
-    }
-    return val;
-}
-
-DiffFieldElem::DiffFieldElem(FieldElem &elem1, FieldElem &elem2, ZKSystem &_system) :
-    child_a(elem1), child_b(elem2), FieldElem("(" + elem1.name + "-" + elem2.name + ")", _system) {};
-
-int DiffFieldElem::eval() {
-    if (!is_set) {
-        val = child_a.eval() - child_b.eval();
-        system.pb.val(pb_var) = val;
-        is_set = true;
-    }
-    return val;
-}
-
-ProdFieldElem::ProdFieldElem(FieldElem &elem1, FieldElem &elem2, ZKSystem &_system) :
-    child_a(elem1), child_b(elem2), FieldElem("(" + elem1.name + "*" + elem2.name + ")", _system) {};
-
-int ProdFieldElem::eval() {
-    if (!is_set) {
-        val = child_a.eval() * child_b.eval();
-        system.pb.val(pb_var) = val;
-        is_set = true;
-    }
-    return val;
-}
-
-struct BitArray {
-    std::vector<FieldElem *> bits;
-    int size;
-    ZKSystem &system;
-
-    BitArray(ZKSystem &_system, std::string name, int _size) : system(_system), size(_size) {
-        for (int i=0; i<size; i++) {
-            bits.push_back(&system.def(name + std::to_string(i)));
-        }
-    }
-
-    BitArray(ZKSystem &_system, std::vector<FieldElem *> _bits) : system(_system), size(_bits.size()), bits(_bits) {}
-
-    FieldElem & operator[](int i) {
-        return *bits[i];
-    }
-
-    void set(std::vector<int> elems) {
-        for (int i=0; i<size; i++) {
-            bits[i]->set(elems[i]);
-        }
-    }
-
-    void set(int x) {
-        for (int i=0; i<size; i++) {
-            bits[i]->set((x >> (size - i - 1)) % 2);
-        }
-    }
-
-    void make_public() {
-        for (auto bit : bits) {
-            bit->make_public();
-        }
-    }
-
-    std::vector<int> eval() {
-        std::vector<int> vals;
-        for (auto bit : bits) {
-            vals.push_back(bit->eval());
-        }
-        return vals;
-    }
-
-    FieldElem & to_field_elem() {
-        FieldElem *elem = &((1 << (size - 1)) * (*bits[0]));
-        for (int i=1; i<size; i++) {
-            elem = &(*elem + (1 << (size - i - 1)) * (*bits[i]));
-        }
-        FieldElem &elem_ref = *elem;
-        return elem_ref;
-    }
-
-    friend FieldElem & operator>(BitArray &arr1, BitArray &arr2);
-    friend FieldElem & operator<(BitArray &arr1, BitArray &arr2);
-    friend FieldElem & operator>=(BitArray &arr1, BitArray &arr2);
-    friend FieldElem & operator<=(BitArray &arr1, BitArray &arr2);
-    friend FieldElem & operator==(BitArray &arr1, BitArray &arr2);
-
-    friend BitArray operator^(BitArray &arr1, BitArray &arr2);
-};
-
-FieldElem & operator>(BitArray &a, BitArray &b) {
-    FieldElem *out = &((1 - b[0]) * a[0]);  // most significant bit lowest
-    FieldElem *equal = &(a[0] * b[0] + (1 - a[0]) * (1 - b[0]));
-    for (int i=1; i<a.size; i++) {
-        out = &(*out + (1 - *out) * (*equal) * ((1 - b[i]) * a[i]));
-        equal = &(*equal * (a[i] * b[i] + (1 - a[i]) * (1 - b[i])));
-    }
-    FieldElem &out_ref = *out;
-    return out_ref;
-}
-
-FieldElem & operator<(BitArray &a, BitArray &b) {
-    FieldElem &out_ref = b > a;
-    return out_ref;
-}
-
-FieldElem & operator==(BitArray &a, BitArray &b) {
-    FieldElem *out = &(a[0] * b[0] + (1 - a[0]) * (1 - b[0]));
-    for (int i=1; i<a.size; i++) {
-        out = &(*out * (a[i] * b[i] + (1 - a[i]) * (1 - b[i])));
-    }
-    FieldElem &out_ref = *out;
-    return out_ref;
-}
-
-FieldElem & operator>=(BitArray &a, BitArray &b) {
-    FieldElem &agtb = a > b;
-    FieldElem &out = agtb + (1 - agtb) * (a == b);
-    return out;
-}
-
-FieldElem & operator<=(BitArray &a, BitArray &b) {
-    FieldElem &out = b >= a;
-    return out;
-}
-
-BitArray operator^(BitArray &a, BitArray &b) {
-    std::vector<FieldElem *> elems;
-    for (int i=0; i<a.size; i++) {
-        elems.push_back(&(a[i] * (1 - b[i]) + (1 - a[i]) * b[i]));
-    }
-    return BitArray(a.system, elems);
-}
+#include "verifier.hpp"
 
 int main()
 {
@@ -381,74 +24,244 @@ int main()
   BitArray b(system, "b", 8);
   BitArray c(system, "c", 8);
 
-  BitArray key(system, "key", 8);
-
-  auto &agtb = a > b;
-  auto &bgtc = b > c;
-  auto &agtc = a > c;
+  std::vector<BitArray> bids = {a, b, c};
+  SecondPriceAuction auction(bids);
 
-  auto &a_winner = agtb * agtc;
-  auto &b_winner = (1 - a_winner) * bgtc;
-  auto &c_winner = (1 - a_winner) * (1 - b_winner);
+  // bidders are numbered from 1
+  auto &winner = *auction.winner + 1;
+  auto &price = *auction.price;
 
-  auto &a_second = (1 - a_winner) * (agtb + (1 - agtb) * agtc);
-  auto &b_second = (1 - b_winner) * (bgtc + (1 - bgtc) * (1 - agtb));
-  auto &c_second = (1 - a_second) * (1 - b_second);
+  // every bidder has published a commitment to their bid
+  BidCommitment acommit(a, "a");
+  BidCommitment bcommit(b, "b");
+  BidCommitment ccommit(c, "c");
 
-  auto &winner = 1 * a_winner + 2 * b_winner + 3 * c_winner;
-  auto &price = a.to_field_elem() * a_second + b.to_field_elem() * b_second + c.to_field_elem() * c_second;
-
-  auto ahash = a ^ key;
-  auto bhash = b ^ key;
-  auto chash = c ^ key;
+  // the commitments stay private; the verifier only sees the root of a
+  // tree over them, whatever the number of bidders
+  MerkleRoot commitments({&acommit.value, &bcommit.value, &ccommit.value});
 
   winner.make_public();
-  ahash.make_public();
-  bhash.make_public();
-  chash.make_public();
   price.make_public();
-  key.make_public();
+  commitments.make_public();
 
-  system.allocate();
+  system.compile();
 
   // set inputs
   a.set(5);
   b.set(12);
   c.set(14);
-  key.set(1337);
+  const FieldT anonce = random_nonce(), bnonce = random_nonce(), cnonce = random_nonce();
+  acommit.set_nonce(anonce);
+  bcommit.set_nonce(bnonce);
+  ccommit.set_nonce(cnonce);
 
   // compute intermediate variables and outputs
-  int winner_output = winner.eval();
-  auto ahash_output = ahash.eval();
-  auto bhash_output = bhash.eval();
-  auto chash_output = chash.eval();
-  int price_output = price.eval();
-
-  auto keypair = system.make_keypair();
-  auto proof = system.make_proof(keypair);
-  bool verified = system.verify_proof(keypair, proof);
-
+  FieldT winner_output = winner.eval();
+  FieldT acommit_output = acommit.eval();
+  FieldT bcommit_output = bcommit.eval();
+  FieldT ccommit_output = ccommit.eval();
+  FieldT price_output = price.eval();
+  FieldT root_output = commitments.root->eval();
+
+  // the keypair only depends on the shape of the circuit, so it is
+  // generated once and reused by every later run
+  KeyCache key_cache("keys");
+  ProverSession session(key_cache.get(system));
+  auto proof = session.prove(system);
+  const size_t prove_peak_kb = session.last_peak_kb;
+  bool verified = session.verify(system, proof);
+  const size_t verify_peak_kb = session.last_peak_kb;
+
+  cout << "Circuit nodes: " << system.arena.n_allocations << " (" << system.arena.bytes_used << " bytes, "
+       << system.arena.blocks.size() << " arena blocks)" << endl;
+  cout << "Number of R1CS constraints: " << system.pb.num_constraints() << endl;
+  cout << "Number of variables: " << system.pb.num_variables() << endl;
+  cout << "Number of public inputs: " << system.pb.num_inputs() << endl;
+  cout << "Keypair: " << (key_cache.hit ? "loaded from cache" : "generated") << endl;
   cout << "Verification status: " << verified << endl;
+  cout << "Peak RSS: prove " << prove_peak_kb << " kB, verify " << verify_peak_kb << " kB"
+       << (session.peak_per_call ? "" : " (process-wide)") << endl;
   cout << "Winner: " << winner_output << endl;
   cout << "Price: " << price_output << endl;
 
-  cout << "ahash: ";
-  for (auto val : ahash_output) {
-      cout << val << ' ';
+  // bidders computed their commitments themselves, outside the circuit
+  cout << "Commitments match: "
+       << (commit_bid(5, anonce) == acommit_output && commit_bid(12, bnonce) == bcommit_output
+           && commit_bid(14, cnonce) == ccommit_output) << endl;
+
+  // the auctioneer builds the same tree outside the circuit and gives
+  // every bidder the path to their commitment
+  MerkleTree tree({acommit_output, bcommit_output, ccommit_output});
+  bool paths_ok = true;
+  for (size_t i = 0; i < 3; i++) {
+      paths_ok = verify_merkle_path(root_output, tree.levels[0][i], tree.path(i)) && paths_ok;
+  }
+  cout << "Merkle root matches: " << (tree.root() == root_output) << ", paths verify: " << paths_ok << endl;
+
+  // the next auction reuses the compiled circuit and keys, and only pays
+  // for its witness and proof
+  system.reset_witness();
+  a.set(20);
+  b.set(3);
+  c.set(9);
+  acommit.set_nonce(random_nonce());
+  bcommit.set_nonce(random_nonce());
+  ccommit.set_nonce(random_nonce());
+
+  auto next_proof = session.prove(system);
+  cout << "Next auction: verification status " << session.verify(system, next_proof)
+       << ", winner " << winner.eval() << ", price " << price.eval() << endl;
+
+  // a batch of auctions checked together, then again with a forged price
+  BatchVerifier<default_r1cs_ppzksnark_pp> batch(*session.vk);
+  const std::vector<std::vector<unsigned long long> > batch_bids = {{5, 12, 14}, {20, 3, 9}, {7, 7, 1}, {30, 2, 31}};
+  for (const auto &batch_bid : batch_bids) {
+    system.reset_witness();
+    a.set(batch_bid[0]);
+    b.set(batch_bid[1]);
+    c.set(batch_bid[2]);
+    acommit.set_nonce(random_nonce());
+    bcommit.set_nonce(random_nonce());
+    ccommit.set_nonce(random_nonce());
+    auto batch_proof = session.prove(system);
+    batch.add(system.pb.primary_input(), batch_proof);
+  }
+  const bool batch_valid = batch.verify_all();
+
+  // the primary input is in make_public() order: winner, price, root
+  auto forged_input = batch.inputs.back();
+  forged_input[1] = forged_input[1] + FieldT::one();
+  batch.add(forged_input, batch.proofs.back());
+  const std::vector<bool> flags = batch.verify();
+  bool only_forged_flagged = true;
+  for (size_t i = 0; i < flags.size(); i++) {
+    only_forged_flagged = only_forged_flagged && flags[i] == (i + 1 < flags.size());
+  }
+  cout << "Batch verification: " << batch_bids.size() << " proofs valid " << batch_valid
+       << ", with a forged price valid " << batch.verify_all() << ", forged proof found " << only_forged_flagged << endl;
+
+  // the same auctions proven side by side, each proof checked against
+  // the public inputs of its own instance
+  BatchProver prover(system, session.pk, 2);
+  auto proved = prover.prove(batch_bids.size(), [&](size_t i) {
+    a.set(batch_bids[i][0]);
+    b.set(batch_bids[i][1]);
+    c.set(batch_bids[i][2]);
+    acommit.set_nonce(random_nonce());
+    bcommit.set_nonce(random_nonce());
+    ccommit.set_nonce(random_nonce());
+  });
+  bool proved_ok = true;
+  for (const ProvedInstance &instance : proved) {
+    proved_ok = session.verify(instance.primary_input, instance.proof) && proved_ok;
+  }
+  // and not against anyone else's
+  proved_ok = proved_ok && !session.verify(proved[1].primary_input, proved[0].proof);
+  cout << "Batch prover: " << proved.size() << " proofs on " << prover.n_workers << " workers, all verify " << proved_ok << endl;
+
+#ifdef CURVE_ALT_BN128
+  {
+    // a proof and key as they travel, in the compressed binary format
+    std::stringstream proof_out, vk_out;
+    write_proof(proof_out, proved[0].proof);
+    write_verification_key(vk_out, *session.vk);
+    const std::string proof_bytes = proof_out.str(), vk_bytes = vk_out.str();
+
+    Proof proof_read;
+    VerificationKey vk_read;
+    std::istringstream proof_in(proof_bytes), vk_in(vk_bytes);
+    const bool read_ok = read_proof(proof_in, proof_read) && read_verification_key(vk_in, vk_read);
+    const bool read_verifies = read_ok &&
+      r1cs_ppzksnark_verifier_strong_IC<default_r1cs_ppzksnark_pp>(vk_read, proved[0].primary_input, proof_read);
+
+    // a flipped header bit or point flag fails the read; a flipped
+    // coordinate bit either fails it or gives a proof that doesn't verify
+    auto proof_rejected = [&](size_t byte, unsigned char mask) {
+      std::string bytes = proof_bytes;
+      bytes[byte] ^= mask;
+      std::istringstream in(bytes);
+      Proof corrupted;
+      return !read_proof(in, corrupted) ||
+        !r1cs_ppzksnark_verifier_strong_IC<default_r1cs_ppzksnark_pp>(vk_read, proved[0].primary_input, corrupted);
+    };
+    auto key_read_fails = [&](size_t byte, unsigned char mask) {
+      std::string bytes = vk_bytes;
+      bytes[byte] ^= mask;
+      std::istringstream in(bytes);
+      VerificationKey corrupted;
+      return !read_verification_key(in, corrupted);
+    };
+    const size_t first_point = 8, x_last_byte = first_point + PointCodec<default_r1cs_ppzksnark_pp>::g1_size - 1;
+    const bool corruption_caught = proof_rejected(4, 0x01) && proof_rejected(first_point, 0x80) &&
+      proof_rejected(x_last_byte, 0x01) && key_read_fails(5, 0x01) && key_read_fails(first_point, 0x80);
+
+    cout << "Serialized proof " << proof_bytes.size() << " bytes, key " << vk_bytes.size() << " bytes: read back "
+         << read_ok << ", verifies " << read_verifies << ", corruption caught " << corruption_caught << endl;
   }
-  cout << endl;
+#endif
+
+  {
+    // a uniform-price auction with a tie at the clearing price, checked
+    // against sorting the bids outside the circuit: ties go to the lower
+    // index, and the winners pay the best losing bid
+    ZKSystem uniform_system;
+    const std::vector<unsigned long long> values = {7, 15, 12, 9, 12, 3};
+    const size_t k = 2;
+    std::vector<BitArray> uniform_bids;
+    for (size_t i = 0; i < values.size(); i++) {
+      uniform_bids.emplace_back(uniform_system, "u" + std::to_string(i), 8);
+    }
+    UniformPriceAuction uniform(uniform_bids, k);
+    for (FieldElem *uniform_winner : uniform.winners) {
+      uniform_winner->make_public();
+    }
+    uniform.price->make_public();
+    uniform_system.compile();
+    for (size_t i = 0; i < values.size(); i++) {
+      uniform_bids[i].set(values[i]);
+    }
+
+    std::vector<size_t> order(values.size());
+    for (size_t i = 0; i < order.size(); i++) {
+      order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t x, size_t y) {
+      return values[x] > values[y];
+    });
+    bool outputs_ok = uniform.price->eval() == FieldT((long) values[order[k]]);
+    for (size_t j = 0; j < order.size(); j++) {
+      outputs_ok = outputs_ok && uniform.winners[order[j]]->eval() == FieldT(j < k ? 1L : 0L);
+    }
 
-  cout << "bhash: ";
-  for (auto val : bhash_output) {
-      cout << val << ' ';
+    const KeyPair uniform_keypair = uniform_system.make_keypair();
+    const Proof uniform_proof = uniform_system.make_proof(uniform_keypair);
+    cout << "Uniform price auction: verification status " << uniform_system.verify_proof(uniform_keypair, uniform_proof)
+         << ", price " << uniform.price->eval() << ", outputs match a native sort: " << outputs_ok << endl;
   }
-  cout << endl;
 
-  cout << "chash: ";
-  for (auto val : chash_output) {
-      cout << val << ' ';
+  {
+    // public bits packed into field elements have to match what a
+    // verifier packs from the bits it expects, and unpack back to them
+    ZKSystem packed_system;
+    BitArray x(packed_system, "x", 8);
+    BitArray y(packed_system, "y", 32);
+    PackedPublicInputs public_bits(packed_system, {&x, &y});
+    packed_system.compile();
+    x.set(0xa5);
+    y.set(0xdeadbeef);
+
+    libff::bit_vector expected_bits = to_bits(0xa5, 8);
+    const libff::bit_vector y_bits = to_bits(0xdeadbeef, 32);
+    expected_bits.insert(expected_bits.end(), y_bits.begin(), y_bits.end());
+    const std::vector<FieldT> packed_output = public_bits.eval();
+
+    const KeyPair packed_keypair = packed_system.make_keypair();
+    const Proof packed_proof = packed_system.make_proof(packed_keypair);
+    cout << "Packed public inputs: " << packed_system.pb.num_inputs() << " for " << expected_bits.size()
+         << " bits, verification status " << packed_system.verify_proof(packed_keypair, packed_proof)
+         << ", match " << (pack_public_bits(expected_bits) == packed_output)
+         << ", unpack " << (unpack_public_bits(packed_output, expected_bits.size()) == expected_bits) << endl;
   }
-  cout << endl;
 
   return 0;
 }
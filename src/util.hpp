@@ -1,38 +1,34 @@
 #include <fstream>
+#include <vector>
 
 #include "libsnark/zk_proof_systems/ppzksnark/r1cs_ppzksnark/r1cs_ppzksnark.hpp"
 #include "libff/algebra/curves/public_params.hpp"
+#include "libff/algebra/scalar_multiplication/multiexp.hpp"
 
 using namespace libsnark;
 using namespace libff;
 using namespace std;
 
+// Every point is normalised with one batched inversion per group, instead
+// of one field inversion per point.
 template<typename ppT>
-void print_vk_to_file(r1cs_ppzksnark_verification_key<ppT> vk, string pathToFile)
+void print_vk_to_file(const r1cs_ppzksnark_verification_key<ppT> &vk, const string &pathToFile)
 {
   ofstream vk_data;
   vk_data.open(pathToFile);
 
-  G2<ppT> A(vk.alphaA_g2);
-  A.to_affine_coordinates();
-  G1<ppT> B(vk.alphaB_g1);
-  B.to_affine_coordinates();
-  G2<ppT> C(vk.alphaC_g2);
-  C.to_affine_coordinates();
+  const accumulation_vector<G1<ppT>> &IC = vk.encoded_IC_query;
 
-  G2<ppT> gamma(vk.gamma_g2);
-  gamma.to_affine_coordinates();
-  G1<ppT> gamma_beta_1(vk.gamma_beta_g1);
-  gamma_beta_1.to_affine_coordinates();
-  G2<ppT> gamma_beta_2(vk.gamma_beta_g2);
-  gamma_beta_2.to_affine_coordinates();
-
-  G2<ppT> Z(vk.rC_Z_g2);
-  Z.to_affine_coordinates();
+  vector<G2<ppT>> g2 = {vk.alphaA_g2, vk.alphaC_g2, vk.gamma_g2, vk.gamma_beta_g2, vk.rC_Z_g2};
+  vector<G1<ppT>> g1 = {vk.alphaB_g1, vk.gamma_beta_g1, IC.first};
+  for(size_t i=0; i<IC.size(); i++) {
+    g1.push_back(IC.rest[i]);
+  }
+  batch_to_special<G2<ppT>>(g2);
+  batch_to_special<G1<ppT>>(g1);
 
-  accumulation_vector<G1<ppT>> IC(vk.encoded_IC_query);
-  G1<ppT> IC_0(IC.first);
-  IC_0.to_affine_coordinates();
+  const G2<ppT> &A = g2[0], &C = g2[1], &gamma = g2[2], &gamma_beta_2 = g2[3], &Z = g2[4];
+  const G1<ppT> &B = g1[0], &gamma_beta_1 = g1[1], &IC_0 = g1[2];
 
   vk_data << A.X << endl;
   vk_data << A.Y << endl;
@@ -58,41 +54,26 @@ void print_vk_to_file(r1cs_ppzksnark_verification_key<ppT> vk, string pathToFile
   vk_data << IC_0.X << endl;
   vk_data << IC_0.Y << endl;
 
-  for(size_t i=0; i<IC.size(); i++) {
-    G1<ppT> IC_N(IC.rest[i]);
-    IC_N.to_affine_coordinates();
-    vk_data << IC_N.X << endl;
-    vk_data << IC_N.Y << endl;
+  for(size_t i=3; i<g1.size(); i++) {
+    vk_data << g1[i].X << endl;
+    vk_data << g1[i].Y << endl;
   }
 
   vk_data.close();
 }
 
 template<typename ppT>
-void print_proof_to_file(r1cs_ppzksnark_proof<ppT> proof, string pathToFile)
+void print_proof_to_file(const r1cs_ppzksnark_proof<ppT> &proof, const string &pathToFile)
 {
   ofstream proof_data;
   proof_data.open(pathToFile);
 
-  G1<ppT> A_g(proof.g_A.g);
-  A_g.to_affine_coordinates();
-  G1<ppT> A_h(proof.g_A.h);
-  A_h.to_affine_coordinates();
-
+  vector<G1<ppT>> g1 = {proof.g_A.g, proof.g_A.h, proof.g_B.h, proof.g_C.g, proof.g_C.h, proof.g_H, proof.g_K};
+  batch_to_special<G1<ppT>>(g1);
   G2<ppT> B_g(proof.g_B.g);
   B_g.to_affine_coordinates();
-  G1<ppT> B_h(proof.g_B.h);
-  B_h.to_affine_coordinates();
-
-  G1<ppT> C_g(proof.g_C.g);
-  C_g.to_affine_coordinates();
-  G1<ppT> C_h(proof.g_C.h);
-  C_h.to_affine_coordinates();
-
-  G1<ppT> H(proof.g_H);
-  H.to_affine_coordinates();
-  G1<ppT> K(proof.g_K);
-  K.to_affine_coordinates();
+
+  const G1<ppT> &A_g = g1[0], &A_h = g1[1], &B_h = g1[2], &C_g = g1[3], &C_h = g1[4], &H = g1[5], &K = g1[6];
 
   proof_data << A_g.X << endl;
   proof_data << A_g.Y << endl;
@@ -0,0 +1,149 @@
+#ifndef VERIFIER_HPP_
+#define VERIFIER_HPP_
+
+#include <vector>
+
+#include "libff/algebra/scalar_multiplication/multiexp.hpp"
+#include "libsnark/zk_proof_systems/ppzksnark/r1cs_ppzksnark/r1cs_ppzksnark.hpp"
+
+#include "profiling.hpp"
+
+using namespace libsnark;
+
+// Verifies many proofs against one verification key at once. A proof is
+// accepted by the five PGHR13 pairing checks
+//
+//   e(A, alphaA) = e(A', g2)            e(alphaB, B) = e(B', g2)
+//   e(C, alphaC) = e(C', g2)            e(A + acc, B) = e(H, rC_Z) e(C, g2)
+//   e(K, gamma) = e(A + acc + C, gamma_beta_g2) e(gamma_beta_g1, B)
+//
+// and each of them, for every proof, is raised to its own random power
+// and all of them multiplied together. Everything paired with a key
+// element then folds into one multi-exponentiation per key element, and
+// the three checks pairing with the proof's B fold into a single G1
+// point per proof. That leaves N + 6 Miller loops and one final
+// exponentiation for the batch, against 12N and 5N checking them one by
+// one. A bad proof passes only if the random powers happen to cancel it
+// out, with probability about 1 / r.
+template<typename ppT>
+struct BatchVerifier {
+    const r1cs_ppzksnark_verification_key<ppT> &vk;
+    std::vector<r1cs_ppzksnark_primary_input<ppT>> inputs;
+    std::vector<r1cs_ppzksnark_proof<ppT>> proofs;
+
+    BatchVerifier(const r1cs_ppzksnark_verification_key<ppT> &_vk) : vk(_vk) {}
+
+    void add(const r1cs_ppzksnark_primary_input<ppT> &input, const r1cs_ppzksnark_proof<ppT> &proof) {
+        inputs.push_back(input);
+        proofs.push_back(proof);
+    }
+
+    size_t size() const {
+        return proofs.size();
+    }
+
+    // true if every proof verifies, up to the soundness error above
+    bool verify_all() const {
+        typedef libff::Fr<ppT> Fr;
+        typedef libff::G1<ppT> G1;
+        typedef libff::Fqk<ppT> Fqk;
+
+        const size_t n = proofs.size();
+        if (n == 0) {
+            return true;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (inputs[i].size() != vk.encoded_IC_query.domain_size() || !proofs[i].is_well_formed()) {
+                return false;
+            }
+        }
+
+        // bases and powers for the multi-exponentiations, one per key
+        // element; the g2 one takes four terms per proof
+        std::vector<G1> alphaA_bases(n), alphaC_bases(n), rC_Z_bases(n), gamma_bases(n), gamma_beta_bases(n), one_bases(4 * n);
+        std::vector<Fr> alphaA_powers(n), alphaC_powers(n), rC_Z_powers(n), gamma_powers(n), gamma_beta_powers(n), one_powers(4 * n);
+        std::vector<Fqk> per_proof(n);
+
+#ifdef MULTICORE
+        // the pairing code below profiles itself, and runs on every thread
+        ProfilingOff quiet;
+#pragma omp parallel for
+#endif
+        for (size_t i = 0; i < n; i++) {
+            const r1cs_ppzksnark_proof<ppT> &proof = proofs[i];
+            const Fr r1 = Fr::random_element(), r2 = Fr::random_element(), r3 = Fr::random_element(),
+                r4 = Fr::random_element(), r5 = Fr::random_element();
+
+            const G1 acc = vk.encoded_IC_query.template accumulate_chunk<Fr>(inputs[i].begin(), inputs[i].end(), 0).first;
+            const G1 A_acc = proof.g_A.g + acc;
+
+            alphaA_bases[i] = proof.g_A.g;
+            alphaA_powers[i] = r1;
+            alphaC_bases[i] = proof.g_C.g;
+            alphaC_powers[i] = r3;
+            rC_Z_bases[i] = proof.g_H;
+            rC_Z_powers[i] = r4;
+            gamma_bases[i] = proof.g_K;
+            gamma_powers[i] = r5;
+            gamma_beta_bases[i] = A_acc + proof.g_C.g;
+            gamma_beta_powers[i] = r5;
+
+            one_bases[4 * i] = proof.g_A.h;
+            one_powers[4 * i] = r1;
+            one_bases[4 * i + 1] = proof.g_B.h;
+            one_powers[4 * i + 1] = r2;
+            one_bases[4 * i + 2] = proof.g_C.h;
+            one_powers[4 * i + 2] = r3;
+            one_bases[4 * i + 3] = proof.g_C.g;
+            one_powers[4 * i + 3] = r4;
+
+            // e(alphaB, B)^r2 e(A + acc, B)^r4 e(gamma_beta_g1, B)^-r5
+            const G1 B_pair = r2 * vk.alphaB_g1 + r4 * A_acc - r5 * vk.gamma_beta_g1;
+            per_proof[i] = ppT::miller_loop(ppT::precompute_G1(B_pair), ppT::precompute_G2(proof.g_B.g));
+        }
+
+        Fqk lhs = Fqk::one();
+        for (const Fqk &f : per_proof) {
+            lhs = lhs * f;
+        }
+        lhs = lhs * ppT::miller_loop(ppT::precompute_G1(multi_exp(alphaA_bases, alphaA_powers)), ppT::precompute_G2(vk.alphaA_g2));
+        lhs = lhs * ppT::miller_loop(ppT::precompute_G1(multi_exp(alphaC_bases, alphaC_powers)), ppT::precompute_G2(vk.alphaC_g2));
+        lhs = lhs * ppT::miller_loop(ppT::precompute_G1(multi_exp(gamma_bases, gamma_powers)), ppT::precompute_G2(vk.gamma_g2));
+
+        const Fqk rhs = ppT::double_miller_loop(
+            ppT::precompute_G1(multi_exp(rC_Z_bases, rC_Z_powers)), ppT::precompute_G2(vk.rC_Z_g2),
+            ppT::precompute_G1(multi_exp(gamma_beta_bases, gamma_beta_powers)), ppT::precompute_G2(vk.gamma_beta_g2)) *
+            ppT::miller_loop(ppT::precompute_G1(multi_exp(one_bases, one_powers)), ppT::precompute_G2(libff::G2<ppT>::one()));
+
+        return ppT::final_exponentiation(lhs * rhs.unitary_inverse()) == libff::GT<ppT>::one();
+    }
+
+    // One flag per proof. The batch check runs first; only if it fails
+    // are the proofs checked one by one to find the bad ones.
+    std::vector<bool> verify() const {
+        std::vector<bool> valid(proofs.size(), true);
+        if (verify_all()) {
+            return valid;
+        }
+
+        std::vector<char> ok(proofs.size());
+#ifdef MULTICORE
+        ProfilingOff quiet;
+#pragma omp parallel for
+#endif
+        for (size_t i = 0; i < proofs.size(); i++) {
+            ok[i] = r1cs_ppzksnark_verifier_strong_IC<ppT>(vk, inputs[i], proofs[i]);
+        }
+        for (size_t i = 0; i < proofs.size(); i++) {
+            valid[i] = ok[i];
+        }
+        return valid;
+    }
+
+    static libff::G1<ppT> multi_exp(const std::vector<libff::G1<ppT>> &bases, const std::vector<libff::Fr<ppT>> &powers) {
+        return libff::multi_exp<libff::G1<ppT>, libff::Fr<ppT>, libff::multi_exp_method_bos_coster>(
+            bases.begin(), bases.end(), powers.begin(), powers.end(), 1);
+    }
+};
+
+#endif // VERIFIER_HPP_
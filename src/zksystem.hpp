@@ -0,0 +1,1420 @@
+#ifndef ZKSYSTEM_HPP_
+#define ZKSYSTEM_HPP_
+
+#include <stdlib.h>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <array>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+#include "libff/algebra/fields/field_utils.hpp"
+#include "libsnark/zk_proof_systems/ppzksnark/r1cs_ppzksnark/r1cs_ppzksnark.hpp"
+#include "libsnark/common/default_types/r1cs_ppzksnark_pp.hpp"
+#include "libsnark/gadgetlib1/pb_variable.hpp"
+
+#include "arena.hpp"
+
+using namespace libsnark;
+using namespace std;
+
+typedef libff::Fr<default_r1cs_ppzksnark_pp> FieldT;
+typedef r1cs_ppzksnark_keypair<default_r1cs_ppzksnark_pp> KeyPair;
+typedef r1cs_ppzksnark_proof<default_r1cs_ppzksnark_pp> Proof;
+typedef r1cs_ppzksnark_proving_key<default_r1cs_ppzksnark_pp> ProvingKey;
+typedef r1cs_ppzksnark_verification_key<default_r1cs_ppzksnark_pp> VerificationKey;
+typedef r1cs_ppzksnark_processed_verification_key<default_r1cs_ppzksnark_pp> ProcessedVerificationKey;
+
+struct ZKSystem;
+struct ConstFieldElem;
+struct SumFieldElem;
+struct DiffFieldElem;
+struct ProdFieldElem;
+
+enum WitnessOp {
+    WITNESS_SUM,
+    WITNESS_DIFF,
+    WITNESS_PROD,
+    WITNESS_BIT,
+    WITNESS_INVERSE,
+    WITNESS_PACK
+};
+
+// one step of witness generation, computing node out from nodes a and b
+// (unary steps have b == a; a WITNESS_PACK step instead reads the b
+// operands starting at operands[a]); small steps run on machine
+// integers, the rest in the field
+struct WitnessStep {
+    WitnessOp op;
+    bool small;
+    size_t out, a, b;
+    // which bit of a a WITNESS_BIT step extracts
+    size_t index;
+};
+
+// how comparisons between BitArrays are compiled
+enum Comparator {
+    // scans the bits from the most significant one, about 6n products
+    COMPARE_BITWISE,
+    // decomposes 2^n + a - b into n + 1 bits, n + 2 constraints
+    COMPARE_PACKED
+};
+
+// identifies a non-leaf node by its structure, for hash-consing
+struct NodeKey {
+    WitnessOp op;
+    size_t a, b;
+
+    bool operator==(const NodeKey &other) const {
+        return op == other.op && a == other.a && b == other.b;
+    }
+};
+
+struct NodeKeyHash {
+    size_t operator()(const NodeKey &key) const {
+        size_t h = key.op;
+        h = h * 0x9e3779b97f4a7c15ULL + key.a;
+        h = h * 0x9e3779b97f4a7c15ULL + key.b;
+        return h ^ (h >> 29);
+    }
+};
+
+// Every node carries a static bound on its value: |value| < 2^bits when
+// read as a signed integer. Values bounded by SMALL_BITS are evaluated
+// with long long arithmetic, which can't overflow; anything else (and
+// anything without a known bound) is evaluated in FieldT.
+const size_t SMALL_BITS = 62;
+const size_t WIDE_BITS = 1 << 16;
+
+inline size_t magnitude_bits(long long x) {
+    unsigned long long m = x < 0 ? 0ULL - (unsigned long long) x : (unsigned long long) x;
+    size_t bits = 0;
+    while (m) {
+        bits += 1;
+        m >>= 1;
+    }
+    return bits;
+}
+
+struct FieldElem {
+    ZKSystem &system;
+    pb_variable<FieldT> pb_var;
+    linear_combination<FieldT> lc;
+    size_t id, bits;
+    bool pub, has_var, is_const, live;
+    // has to get a variable even if it is linear in its children
+    bool pinned;
+    // only meaningful for constants (small_val only if is_small());
+    // witness values live in the ZKSystem
+    FieldT val;
+    long long small_val;
+
+    FieldElem(ZKSystem &_system);
+    virtual ~FieldElem() {}
+
+    // readable names are only built on demand, since a node's name spells
+    // out its whole subtree
+    virtual std::string name() const = 0;
+    std::string annotation() const;
+
+    // this node in terms of its children's ids
+    virtual std::string describe() const {
+        return name();
+    }
+
+    bool is_small() const {
+        return bits <= SMALL_BITS;
+    }
+
+    virtual void set(long) {
+        std::cout << "Can't set the value of a non-leaf element" << std::endl;
+        throw 1;
+    }
+    virtual void set(const FieldT &) {
+        std::cout << "Can't set the value of a non-leaf element" << std::endl;
+        throw 1;
+    }
+    // public inputs are numbered in the order they are made public
+    void make_public();
+
+    // One constraint buys a variable standing for the whole linear
+    // combination, so that long chains of sums don't drag ever longer
+    // expressions into every constraint that uses them.
+    void pin() {
+        pinned = true;
+    }
+
+    FieldT eval();
+
+    // appends the step computing this node's witness, if it has one
+    virtual void emit(std::vector<WitnessStep> &, std::vector<size_t> &) const {}
+
+    // lowers this node into lc, emitting a constraint only where a
+    // multiplication (or a public output) needs its own variable
+    virtual void compile() = 0;
+
+    virtual void mark_live() {
+        live = true;
+    }
+
+    void allocate_var();
+    void bind(const linear_combination<FieldT> &expr);
+
+    friend SumFieldElem & operator+(FieldElem &elem1, FieldElem &elem2);
+    friend DiffFieldElem & operator-(FieldElem &elem1, FieldElem &elem2);
+    friend FieldElem & operator*(FieldElem &elem1, FieldElem &elem2);
+
+    friend SumFieldElem & operator+(int x, FieldElem &elem);
+    friend DiffFieldElem & operator-(int x, FieldElem &elem);
+    friend FieldElem & operator*(int x, FieldElem &elem);
+
+    friend SumFieldElem & operator+(FieldElem &elem, int x);
+    friend DiffFieldElem & operator-(FieldElem &elem, int x);
+    friend FieldElem & operator*(FieldElem &elem, int x);
+};
+
+struct LeafFieldElem : public FieldElem {
+    std::string label;
+
+    LeafFieldElem(std::string _label, size_t _bits, ZKSystem &_system);
+
+    virtual std::string name() const {
+        return label;
+    }
+
+    virtual void set(long x);
+    virtual void set(const FieldT &x);
+
+    virtual void compile();
+};
+
+// a constant is folded into the linear combinations that use it, so it
+// never gets a variable or a witness slot of its own
+struct ConstFieldElem : public FieldElem {
+    ConstFieldElem(long x, ZKSystem &_system);
+    ConstFieldElem(const FieldT &x, ZKSystem &_system);
+
+    virtual std::string name() const {
+        if (is_small()) {
+            return std::to_string(small_val);
+        }
+        std::ostringstream out;
+        out << val;
+        return out.str();
+    }
+
+    virtual void compile();
+};
+
+struct SumFieldElem : public FieldElem {
+    FieldElem &child_a, &child_b;
+
+    SumFieldElem(FieldElem &elem1, FieldElem &elem2, ZKSystem &_system);
+
+    virtual std::string name() const {
+        return "(" + child_a.name() + "+" + child_b.name() + ")";
+    }
+
+    virtual std::string describe() const {
+        return "x" + std::to_string(child_a.id) + " + x" + std::to_string(child_b.id);
+    }
+
+    virtual void emit(std::vector<WitnessStep> &tape, std::vector<size_t> &) const {
+        if (!is_const) {
+            tape.push_back(WitnessStep{WITNESS_SUM, is_small(), id, child_a.id, child_b.id, 0});
+        }
+    }
+
+    virtual void compile();
+
+    virtual void mark_live() {
+        live = child_a.live = child_b.live = true;
+    }
+};
+
+struct DiffFieldElem : public FieldElem {
+    FieldElem &child_a, &child_b;
+
+    DiffFieldElem(FieldElem &elem1, FieldElem &elem2, ZKSystem &_system);
+
+    virtual std::string name() const {
+        return "(" + child_a.name() + "-" + child_b.name() + ")";
+    }
+
+    virtual std::string describe() const {
+        return "x" + std::to_string(child_a.id) + " - x" + std::to_string(child_b.id);
+    }
+
+    virtual void emit(std::vector<WitnessStep> &tape, std::vector<size_t> &) const {
+        if (!is_const) {
+            tape.push_back(WitnessStep{WITNESS_DIFF, is_small(), id, child_a.id, child_b.id, 0});
+        }
+    }
+
+    virtual void compile();
+
+    virtual void mark_live() {
+        live = child_a.live = child_b.live = true;
+    }
+};
+
+struct ProdFieldElem : public FieldElem {
+    FieldElem &child_a, &child_b;
+
+    ProdFieldElem(FieldElem &elem1, FieldElem &elem2, ZKSystem &_system);
+
+    virtual std::string name() const {
+        return "(" + child_a.name() + "*" + child_b.name() + ")";
+    }
+
+    virtual std::string describe() const {
+        return "x" + std::to_string(child_a.id) + " * x" + std::to_string(child_b.id);
+    }
+
+    virtual void emit(std::vector<WitnessStep> &tape, std::vector<size_t> &) const {
+        if (!is_const) {
+            tape.push_back(WitnessStep{WITNESS_PROD, is_small(), id, child_a.id, child_b.id, 0});
+        }
+    }
+
+    virtual void compile();
+
+    virtual void mark_live() {
+        live = child_a.live = child_b.live = true;
+    }
+};
+
+// a bit of another node's value, supplied by the prover; whoever creates
+// one is responsible for constraining it
+struct BitFieldElem : public FieldElem {
+    FieldElem &src;
+    size_t index;
+
+    BitFieldElem(FieldElem &_src, size_t _index, ZKSystem &_system);
+
+    virtual std::string name() const {
+        return "bit" + std::to_string(index) + "(" + src.name() + ")";
+    }
+
+    virtual std::string describe() const {
+        return "bit " + std::to_string(index) + " of x" + std::to_string(src.id);
+    }
+
+    virtual void emit(std::vector<WitnessStep> &tape, std::vector<size_t> &) const {
+        tape.push_back(WitnessStep{WITNESS_BIT, true, id, src.id, src.id, index});
+    }
+
+    virtual void compile();
+
+    virtual void mark_live() {
+        live = src.live = true;
+    }
+};
+
+// the inverse of another node's value, or 0 if it has none, supplied by
+// the prover; whoever creates one is responsible for constraining it
+struct InverseFieldElem : public FieldElem {
+    FieldElem &src;
+
+    InverseFieldElem(FieldElem &_src, ZKSystem &_system);
+
+    virtual std::string name() const {
+        return "inv(" + src.name() + ")";
+    }
+
+    virtual std::string describe() const {
+        return "inverse of x" + std::to_string(src.id);
+    }
+
+    virtual void emit(std::vector<WitnessStep> &tape, std::vector<size_t> &) const {
+        tape.push_back(WitnessStep{WITNESS_INVERSE, false, id, src.id, src.id, 0});
+    }
+
+    virtual void compile();
+
+    virtual void mark_live() {
+        live = src.live = true;
+    }
+};
+
+// sum of inputs[i] * 2^(n - 1 - i), most significant input first: one
+// linear combination with no constraints of its own
+struct PackedFieldElem : public FieldElem {
+    std::vector<FieldElem *> inputs;
+
+    PackedFieldElem(const std::vector<FieldElem *> &_inputs, ZKSystem &_system);
+
+    virtual std::string name() const {
+        std::string out = "pack(";
+        for (size_t i = 0; i < inputs.size(); i++) {
+            out += (i ? ", " : "") + inputs[i]->name();
+        }
+        return out + ")";
+    }
+
+    virtual std::string describe() const {
+        std::string out = "pack(";
+        for (size_t i = 0; i < inputs.size(); i++) {
+            out += (i ? ", x" : "x") + std::to_string(inputs[i]->id);
+        }
+        return out + ")";
+    }
+
+    virtual void emit(std::vector<WitnessStep> &tape, std::vector<size_t> &operands) const {
+        tape.push_back(WitnessStep{WITNESS_PACK, is_small(), id, operands.size(), inputs.size(), 0});
+        for (FieldElem *input : inputs) {
+            operands.push_back(input->id);
+        }
+    }
+
+    virtual void compile();
+
+    virtual void mark_live() {
+        live = true;
+        for (FieldElem *input : inputs) {
+            input->live = true;
+        }
+    }
+};
+
+// an explicit constraint a * b = c between nodes
+struct Constraint {
+    FieldElem *a, *b, *c;
+};
+
+struct ZKSystem {
+    protoboard<FieldT> pb;
+    NodeArena arena;
+    std::vector<FieldElem *> elems;
+
+    // structurally identical nodes are only ever built once
+    std::unordered_map<NodeKey, FieldElem *, NodeKeyHash> interned;
+    std::unordered_map<long, ConstFieldElem *> small_constants;
+    // wide constants, keyed by their limbs
+    std::map<std::vector<unsigned long long>, ConstFieldElem *> field_constants;
+    // packs are keyed by the ids of their inputs, in order
+    std::map<std::vector<size_t>, PackedFieldElem *> packs;
+
+    // in make_public() order, which is the order of the primary input
+    std::vector<FieldElem *> public_elems;
+
+    // constraints that gadgets add on top of the expression DAG
+    std::vector<Constraint> constraints;
+    std::set<std::array<size_t, 3> > constrained;
+
+    // used by the BitArray comparison operators
+    Comparator comparator;
+
+    // witness values and whether they are known yet, indexed by node id;
+    // a node's value is in small_values if it is_small(), else in
+    // field_values
+    std::vector<long long> small_values;
+    std::vector<FieldT> field_values;
+    std::vector<char> small, known;
+    bool witness_ready;
+
+    // built once by compile(): the steps computing every non-leaf value,
+    // grouped by depth in the DAG, and the nodes whose values go on the
+    // protoboard. Steps within one level don't depend on each other;
+    // level i is tape[tape_levels[i]] up to tape[tape_levels[i + 1]].
+    std::vector<WitnessStep> tape;
+    std::vector<size_t> tape_levels, operands;
+    std::vector<std::pair<size_t, pb_variable<FieldT> > > witness_vars;
+
+    // levels narrower than this aren't worth handing out to threads
+    size_t min_parallel_width;
+
+    ZKSystem() : comparator(COMPARE_BITWISE), witness_ready(false), min_parallel_width(256) {
+      default_r1cs_ppzksnark_pp::init_public_params();
+    }
+  
+    KeyPair make_keypair() {
+      const r1cs_constraint_system<FieldT> constraint_system = pb.get_constraint_system();
+      return r1cs_ppzksnark_generator<default_r1cs_ppzksnark_pp>(constraint_system);
+    }
+
+    // keys are taken by reference: a proving key can run to hundreds of MB
+    const Proof make_proof(const KeyPair &keypair) {
+        return make_proof(keypair.pk);
+    }
+
+    const Proof make_proof(const ProvingKey &pk) {
+        if (!witness_ready) {
+            generate_witness();
+        }
+        return r1cs_ppzksnark_prover<default_r1cs_ppzksnark_pp>(pk, pb.primary_input(), pb.auxiliary_input());
+    }
+
+    bool verify_proof(const KeyPair &keypair, const Proof &proof) {
+        return verify_proof(keypair.vk, proof);
+    }
+
+    bool verify_proof(const VerificationKey &vk, const Proof &proof) {
+        if (!witness_ready) {
+            generate_witness();
+        }
+        return r1cs_ppzksnark_verifier_strong_IC<default_r1cs_ppzksnark_pp>(vk, pb.primary_input(), proof);
+    }
+
+    // The plain verifier redoes the G2 precomputations of the key for
+    // every proof. Processing the key once and verifying against that
+    // skips them, which is most of the cost for a handful of inputs.
+    ProcessedVerificationKey process_key(const VerificationKey &vk) const {
+        return r1cs_ppzksnark_verifier_process_vk<default_r1cs_ppzksnark_pp>(vk);
+    }
+
+    bool verify_proof(const ProcessedVerificationKey &pvk, const Proof &proof) {
+        if (!witness_ready) {
+            generate_witness();
+        }
+        return r1cs_ppzksnark_online_verifier_strong_IC<default_r1cs_ppzksnark_pp>(pvk, pb.primary_input(), proof);
+    }
+
+    // bits bounds the values the leaf will be set to, see SMALL_BITS
+    LeafFieldElem & def(std::string label, size_t bits = WIDE_BITS) {
+        return make<LeafFieldElem>(label, bits, *this);
+    }
+
+    ConstFieldElem & constant(long x) {
+        ConstFieldElem *&elem = small_constants[x];
+        if (!elem) {
+            elem = &make<ConstFieldElem>(x, *this);
+        }
+        return *elem;
+    }
+
+    ConstFieldElem & constant(const FieldT &x) {
+        const auto bigint = x.as_bigint();
+        std::vector<unsigned long long> limbs(bigint.data, bigint.data + FieldT::num_limbs);
+        ConstFieldElem *&elem = field_constants[limbs];
+        if (!elem) {
+            elem = &make<ConstFieldElem>(x, *this);
+        }
+        return *elem;
+    }
+
+    ConstFieldElem & power_of_two(size_t k) {
+        if (k < SMALL_BITS) {
+            return constant(1L << k);
+        }
+        return constant(FieldT(2) ^ k);
+    }
+
+    // nodes live in the arena and are owned by the system
+    template<typename T, typename... Args>
+    T & make(Args&&... args) {
+        T *elem = arena.make<T>(std::forward<Args>(args)...);
+        register_elem(elem);
+        return *elem;
+    }
+
+    // returns the existing node for op(elem1, elem2) if there is one;
+    // operands of commutative ops are put in id order first
+    template<typename T>
+    T & intern(WitnessOp op, FieldElem &elem1, FieldElem &elem2, bool commutative) {
+        FieldElem *a = &elem1, *b = &elem2;
+        if (commutative && b->id < a->id) {
+            std::swap(a, b);
+        }
+        FieldElem *&elem = interned[NodeKey{op, a->id, b->id}];
+        if (!elem) {
+            elem = &make<T>(*a, *b, *this);
+        }
+        return static_cast<T &>(*elem);
+    }
+
+    // every copy of a BitArray (and every array over the same bits)
+    // shares one packed node
+    PackedFieldElem & pack(const std::vector<FieldElem *> &inputs) {
+        std::vector<size_t> ids;
+        for (FieldElem *input : inputs) {
+            ids.push_back(input->id);
+        }
+        PackedFieldElem *&elem = packs[ids];
+        if (!elem) {
+            elem = &make<PackedFieldElem>(inputs, *this);
+        }
+        return *elem;
+    }
+
+    BitFieldElem & bit_of(FieldElem &src, size_t index) {
+        FieldElem *&elem = interned[NodeKey{WITNESS_BIT, src.id, index}];
+        if (!elem) {
+            elem = &make<BitFieldElem>(src, index, *this);
+        }
+        return static_cast<BitFieldElem &>(*elem);
+    }
+
+    InverseFieldElem & inverse_of(FieldElem &src) {
+        FieldElem *&elem = interned[NodeKey{WITNESS_INVERSE, src.id, src.id}];
+        if (!elem) {
+            elem = &make<InverseFieldElem>(src, *this);
+        }
+        return static_cast<InverseFieldElem &>(*elem);
+    }
+
+    // adds a * b = c to the constraint system; the nodes involved are
+    // compiled even if no public output depends on them
+    void enforce(FieldElem &a, FieldElem &b, FieldElem &c) {
+        if (constrained.insert(std::array<size_t, 3>{{a.id, b.id, c.id}}).second) {
+            constraints.push_back(Constraint{&a, &b, &c});
+        }
+    }
+
+    void enforce_boolean(FieldElem &x);
+
+    // the width bits of value, most significant first, constrained to be
+    // boolean and to pack back to value
+    std::vector<FieldElem *> decompose(FieldElem &value, size_t width);
+
+    void register_elem(FieldElem *elem) {
+        elem->id = elems.size();
+        elems.push_back(elem);
+        small.push_back(elem->is_small());
+        small_values.push_back(elem->is_const && elem->is_small() ? elem->small_val : 0);
+        field_values.push_back(elem->is_const && !elem->is_small() ? elem->val : FieldT::zero());
+        known.push_back(elem->is_const);
+    }
+
+    void set_value(FieldElem &elem, long x) {
+        if (elem.is_small()) {
+            if (magnitude_bits(x) > elem.bits) {
+                cout << "value " << x << " doesn't fit in " << elem.name() << endl;
+                throw 1;
+            }
+            small_values[elem.id] = x;
+        } else {
+            field_values[elem.id] = FieldT(x);
+        }
+        known[elem.id] = true;
+        witness_ready = false;
+    }
+
+    void set_value(FieldElem &elem, const FieldT &x) {
+        if (elem.is_small()) {
+            if (x.as_bigint().num_bits() > elem.bits) {
+                cout << "value " << x << " doesn't fit in " << elem.name() << endl;
+                throw 1;
+            }
+            small_values[elem.id] = x.as_ulong();
+        } else {
+            field_values[elem.id] = x;
+        }
+        known[elem.id] = true;
+        witness_ready = false;
+    }
+
+    FieldT field_value(size_t id) const {
+        return small[id] ? FieldT((long) small_values[id]) : field_values[id];
+    }
+
+    FieldT eval(FieldElem &elem) {
+        if (!witness_ready) {
+            generate_witness();
+        }
+        if (!known[elem.id]) {
+            cout << "can't eval " << elem.name() << " without values for all of its leaves" << endl;
+            throw 1;
+        }
+        return field_value(elem.id);
+    }
+
+    void run_step(const WitnessStep &step) {
+        if (step.op == WITNESS_BIT) {
+            // small values here are never negative, and are below 2^62
+            known[step.out] = known[step.a];
+            if (small[step.a]) {
+                small_values[step.out] = step.index < SMALL_BITS ? (small_values[step.a] >> step.index) & 1 : 0;
+            } else {
+                small_values[step.out] = field_values[step.a].as_bigint().test_bit(step.index);
+            }
+            return;
+        }
+        if (step.op == WITNESS_PACK) {
+            const size_t *input = &operands[step.a];
+            bool all_known = true;
+            if (step.small) {
+                long long x = 0;
+                for (size_t i = 0; i < step.b; i++) {
+                    x = 2 * x + small_values[input[i]];
+                    all_known = all_known && known[input[i]];
+                }
+                small_values[step.out] = x;
+            } else {
+                FieldT x = FieldT::zero();
+                for (size_t i = 0; i < step.b; i++) {
+                    x = x + x + field_value(input[i]);
+                    all_known = all_known && known[input[i]];
+                }
+                field_values[step.out] = x;
+            }
+            known[step.out] = all_known;
+            return;
+        }
+        if (step.op == WITNESS_INVERSE) {
+            known[step.out] = known[step.a];
+            const FieldT x = field_value(step.a);
+            field_values[step.out] = x.is_zero() ? FieldT::zero() : x.inverse();
+            return;
+        }
+
+        known[step.out] = known[step.a] && known[step.b];
+        if (step.small) {
+            const long long a = small_values[step.a], b = small_values[step.b];
+            switch (step.op) {
+            case WITNESS_SUM:
+                small_values[step.out] = a + b;
+                break;
+            case WITNESS_DIFF:
+                small_values[step.out] = a - b;
+                break;
+            case WITNESS_PROD:
+                small_values[step.out] = a * b;
+                break;
+            default:
+                break;
+            }
+            return;
+        }
+
+        const FieldT a = field_value(step.a), b = field_value(step.b);
+        switch (step.op) {
+        case WITNESS_SUM:
+            field_values[step.out] = a + b;
+            break;
+        case WITNESS_DIFF:
+            field_values[step.out] = a - b;
+            break;
+        case WITNESS_PROD:
+            field_values[step.out] = a * b;
+            break;
+        default:
+            break;
+        }
+    }
+
+    void generate_witness() {
+        for (size_t level = 0; level + 1 < tape_levels.size(); level++) {
+            const size_t begin = tape_levels[level], end = tape_levels[level + 1];
+            if (end - begin < min_parallel_width) {
+                for (size_t i = begin; i < end; i++) {
+                    run_step(tape[i]);
+                }
+                continue;
+            }
+#ifdef MULTICORE
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+            for (size_t i = begin; i < end; i++) {
+                run_step(tape[i]);
+            }
+        }
+
+        bool complete = true;
+#ifdef MULTICORE
+#pragma omp parallel for reduction(&&:complete)
+#endif
+        for (size_t i = 0; i < witness_vars.size(); i++) {
+            const size_t id = witness_vars[i].first;
+            if (known[id]) {
+                pb.val(witness_vars[i].second) = field_value(id);
+            } else {
+                complete = false;
+            }
+        }
+        if (!complete) {
+            for (const auto &var : witness_vars) {
+                if (!known[var.first]) {
+                    cout << "can't generate witness without a value for " << elems[var.first]->name() << endl;
+                    break;
+                }
+            }
+            throw 1;
+        }
+        witness_ready = true;
+    }
+
+    // Forgets every value but the constants, keeping the circuit, its
+    // variable layout and its constraints, so that the same compiled
+    // system (and keypair) can take the next set of inputs. Without it
+    // an input left unset would quietly keep its previous value.
+    void reset_witness() {
+        for (size_t i = 0; i < elems.size(); i++) {
+            known[i] = elems[i]->is_const;
+        }
+        witness_ready = false;
+    }
+
+    // copies the witness out of the protoboard, so that it can be proven
+    // while the system moves on to the next set of inputs
+    void export_witness(r1cs_primary_input<FieldT> &primary_input, r1cs_auxiliary_input<FieldT> &auxiliary_input) {
+        if (!witness_ready) {
+            generate_witness();
+        }
+        primary_input = pb.primary_input();
+        auxiliary_input = pb.auxiliary_input();
+    }
+
+    // one line per live node, naming children by id
+    void dump(std::ostream &out);
+
+    void compile() {
+        // public elements have to come first on the protoboard, in the
+        // order a verifier passes them in
+        for (FieldElem *elem : public_elems) {
+            elem->allocate_var();
+        }
+        pb.set_input_sizes(public_elems.size());
+
+        for (const Constraint &constraint : constraints) {
+            constraint.a->live = constraint.b->live = constraint.c->live = true;
+        }
+
+        // only nodes that feed a public output need constraints (and a
+        // witness); walking backwards reaches parents before children
+        for (auto it = elems.rbegin(); it != elems.rend(); ++it) {
+            if ((*it)->pub || (*it)->live) {
+                (*it)->mark_live();
+            }
+        }
+
+        // elems is in creation order, so children are always compiled
+        // before their parents
+        for (FieldElem *elem : elems) {
+            if (elem->live) {
+                if (elem->pinned && !elem->has_var && !elem->is_const) {
+                    elem->allocate_var();
+                }
+                elem->compile();
+            }
+        }
+        for (const Constraint &constraint : constraints) {
+            pb.add_r1cs_constraint(r1cs_constraint<FieldT>(constraint.a->lc, constraint.b->lc, constraint.c->lc));
+        }
+
+        // creation order is also a valid evaluation order, so the whole
+        // witness can later be filled in one pass without recursion
+        std::vector<WitnessStep> steps;
+        operands.clear();
+        witness_vars.clear();
+        for (FieldElem *elem : elems) {
+            elem->emit(steps, operands);
+            if (elem->has_var) {
+                witness_vars.push_back(std::make_pair(elem->id, elem->pb_var));
+            }
+        }
+        level_tape(steps);
+        witness_ready = false;
+    }
+
+    // sorts the steps by depth so that each level can be evaluated in
+    // parallel; leaves and constants are at depth 0
+    void level_tape(const std::vector<WitnessStep> &steps) {
+        std::vector<size_t> depth(elems.size(), 0);
+        size_t max_depth = 0;
+        for (const WitnessStep &step : steps) {
+            if (step.op == WITNESS_PACK) {
+                for (size_t i = step.a; i < step.a + step.b; i++) {
+                    depth[step.out] = std::max(depth[step.out], depth[operands[i]] + 1);
+                }
+            } else {
+                depth[step.out] = std::max(depth[step.a], depth[step.b]) + 1;
+            }
+            max_depth = std::max(max_depth, depth[step.out]);
+        }
+
+        tape_levels.assign(max_depth + 1, 0);
+        for (const WitnessStep &step : steps) {
+            tape_levels[depth[step.out]] += 1;
+        }
+        size_t offset = 0;
+        for (size_t &level : tape_levels) {
+            const size_t width = level;
+            level = offset;
+            offset += width;
+        }
+        tape_levels.push_back(offset);
+
+        // depth 0 is empty, so this starts from level 1
+        std::vector<size_t> next(tape_levels.begin(), tape_levels.end() - 1);
+        tape.resize(steps.size());
+        for (const WitnessStep &step : steps) {
+            tape[next[depth[step.out]]++] = step;
+        }
+    }
+
+    // drops every node and the constraint system so that the next
+    // circuit can be built in the same arena blocks
+    void clear() {
+        for (FieldElem *elem : elems) {
+            elem->~FieldElem();
+        }
+        elems.clear();
+        interned.clear();
+        packs.clear();
+        small_constants.clear();
+        public_elems.clear();
+        field_constants.clear();
+        constraints.clear();
+        constrained.clear();
+        arena.release();
+        pb = protoboard<FieldT>();
+        small_values.clear();
+        field_values.clear();
+        small.clear();
+        known.clear();
+        tape.clear();
+        tape_levels.clear();
+        operands.clear();
+        witness_vars.clear();
+        witness_ready = false;
+    }
+
+    ~ZKSystem() {
+        for (FieldElem *elem : elems) {
+            elem->~FieldElem();
+        }
+    }
+
+};
+
+inline FieldElem::FieldElem(ZKSystem &_system) : system(_system), id(0), bits(WIDE_BITS), pub(false), has_var(false), is_const(false), live(false), pinned(false), small_val(0) {};
+
+inline void FieldElem::make_public() {
+    if (!pub) {
+        pub = true;
+        system.public_elems.push_back(this);
+    }
+}
+
+inline FieldT FieldElem::eval() {
+    return system.eval(*this);
+}
+
+// libsnark only keeps annotations in debug builds, so don't pay for the
+// name otherwise
+inline std::string FieldElem::annotation() const {
+#ifdef DEBUG
+    return name();
+#else
+    return "";
+#endif
+}
+
+inline void FieldElem::allocate_var() {
+    pb_var.allocate(system.pb, annotation());
+    has_var = true;
+}
+
+inline void FieldElem::bind(const linear_combination<FieldT> &expr) {
+    if (has_var) {
+        system.pb.add_r1cs_constraint(r1cs_constraint<FieldT>(expr, 1, pb_var), annotation());
+        lc = pb_var;
+    } else {
+        lc = expr;
+    }
+}
+
+// libsnark just concatenates the terms of a sum, so x + y - (y + z)
+// would keep both copies of y; merging terms on the same variable keeps
+// expressions as short as what they actually depend on
+inline linear_combination<FieldT> compact(const linear_combination<FieldT> &expr) {
+    std::vector<linear_term<FieldT>> terms(expr.terms);
+    std::sort(terms.begin(), terms.end(), [](const linear_term<FieldT> &x, const linear_term<FieldT> &y) {
+        return x.index < y.index;
+    });
+    linear_combination<FieldT> result;
+    for (const auto &term : terms) {
+        if (!result.terms.empty() && result.terms.back().index == term.index) {
+            result.terms.back().coeff += term.coeff;
+        } else {
+            result.terms.push_back(term);
+        }
+    }
+    result.terms.erase(std::remove_if(result.terms.begin(), result.terms.end(), [](const linear_term<FieldT> &term) {
+        return term.coeff.is_zero();
+    }), result.terms.end());
+    return result;
+}
+
+inline SumFieldElem & operator+(FieldElem &elem1, FieldElem &elem2) {
+    return elem1.system.intern<SumFieldElem>(WITNESS_SUM, elem1, elem2, true);
+}
+
+inline DiffFieldElem & operator-(FieldElem &elem1, FieldElem &elem2) {
+    return elem1.system.intern<DiffFieldElem>(WITNESS_DIFF, elem1, elem2, false);
+}
+
+// splits elem into constant k and term x if it is k + x, x + k, k - x or
+// x - k; negative is set when x is subtracted, k_negative when k is
+inline bool split_affine(FieldElem &elem, FieldElem *&k, FieldElem *&x, bool &negative, bool &k_negative) {
+    if (elem.is_const) {
+        return false;
+    }
+    if (SumFieldElem *sum = dynamic_cast<SumFieldElem *>(&elem)) {
+        negative = k_negative = false;
+        if (sum->child_a.is_const) {
+            k = &sum->child_a;
+            x = &sum->child_b;
+            return true;
+        }
+        if (sum->child_b.is_const) {
+            k = &sum->child_b;
+            x = &sum->child_a;
+            return true;
+        }
+    }
+    if (DiffFieldElem *diff = dynamic_cast<DiffFieldElem *>(&elem)) {
+        if (diff->child_a.is_const) {
+            k = &diff->child_a;
+            x = &diff->child_b;
+            negative = true;
+            k_negative = false;
+            return true;
+        }
+        if (diff->child_b.is_const) {
+            k = &diff->child_b;
+            x = &diff->child_a;
+            negative = false;
+            k_negative = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Products distribute over a constant offset, (k - x) * y = k * y - x * y,
+// since scaling by k is free. On booleans this lowers a * (1 - b),
+// (1 - a) * (1 - b) and friends to linear combinations around the one
+// product a * b, which hash-consing then shares between all of them.
+inline FieldElem & operator*(FieldElem &elem1, FieldElem &elem2) {
+    FieldElem *k, *x;
+    bool negative, k_negative;
+    FieldElem *other = &elem2;
+    bool split = split_affine(elem1, k, x, negative, k_negative);
+    if (!split && !elem2.is_const) {
+        split = split_affine(elem2, k, x, negative, k_negative);
+        other = &elem1;
+    }
+    if (!split) {
+        return elem1.system.intern<ProdFieldElem>(WITNESS_PROD, elem1, elem2, true);
+    }
+
+    FieldElem &scaled = *k * *other;
+    FieldElem &product = *x * *other;
+    if (k_negative) {
+        return product - scaled;
+    }
+    if (negative) {
+        return scaled - product;
+    }
+    return scaled + product;
+}
+
+inline SumFieldElem & operator+(int x, FieldElem &elem) {
+    auto &constant = elem.system.constant(x);
+    auto &ret = constant + elem;
+    return ret;
+}
+
+inline DiffFieldElem & operator-(int x, FieldElem &elem) {
+    auto &constant = elem.system.constant(x);
+    auto &ret = constant - elem;  // why is this needed to prevent a copy
+    return ret;
+}
+
+inline FieldElem & operator*(int x, FieldElem &elem) {
+    auto &constant = elem.system.constant(x);
+    auto &ret = constant * elem;
+    return ret;
+}
+
+inline SumFieldElem & operator+(FieldElem &elem, int x) {
+    auto &constant = elem.system.constant(x);
+    auto &ret = elem + constant;
+    return ret;
+}
+
+inline DiffFieldElem & operator-(FieldElem &elem, int x) {
+    auto &constant = elem.system.constant(x);
+    auto &ret = elem - constant;
+    return ret;
+}
+
+inline FieldElem & operator*(FieldElem &elem, int x) {
+    auto &constant = elem.system.constant(x);
+    auto &ret = elem * constant;
+    return ret;
+}
+
+inline ConstFieldElem::ConstFieldElem(long x, ZKSystem &_system) : FieldElem(_system) {
+    is_const = true;
+    bits = magnitude_bits(x);
+    val = FieldT(x);
+    small_val = x;
+};
+
+inline ConstFieldElem::ConstFieldElem(const FieldT &x, ZKSystem &_system) : FieldElem(_system) {
+    is_const = true;
+    val = x;
+};
+
+inline void ConstFieldElem::compile() {
+    bind(linear_combination<FieldT>(val));
+}
+
+inline LeafFieldElem::LeafFieldElem(std::string _label, size_t _bits, ZKSystem &_system) : FieldElem(_system), label(_label) {
+    bits = _bits;
+};
+
+inline void LeafFieldElem::set(long x) {
+    /* cout << "setting " << name() << " to " << x << endl; */
+    system.set_value(*this, x);
+}
+
+inline void LeafFieldElem::set(const FieldT &x) {
+    system.set_value(*this, x);
+}
+
+inline void LeafFieldElem::compile() {
+    if (!has_var) {
+        allocate_var();
+    }
+    lc = pb_var;
+}
+
+inline SumFieldElem::SumFieldElem(FieldElem &elem1, FieldElem &elem2, ZKSystem &_system) :
+    child_a(elem1), child_b(elem2), FieldElem(_system) {
+    bits = std::min(std::max(elem1.bits, elem2.bits) + 1, WIDE_BITS);
+    if (elem1.is_const && elem2.is_const) {
+        is_const = true;
+        val = elem1.val + elem2.val;
+        small_val = is_small() ? elem1.small_val + elem2.small_val : 0;
+    }
+};
+
+inline void SumFieldElem::compile() {
+    bind(compact(child_a.lc + child_b.lc));
+}
+
+inline DiffFieldElem::DiffFieldElem(FieldElem &elem1, FieldElem &elem2, ZKSystem &_system) :
+    child_a(elem1), child_b(elem2), FieldElem(_system) {
+    bits = std::min(std::max(elem1.bits, elem2.bits) + 1, WIDE_BITS);
+    if (elem1.is_const && elem2.is_const) {
+        is_const = true;
+        val = elem1.val - elem2.val;
+        small_val = is_small() ? elem1.small_val - elem2.small_val : 0;
+    }
+};
+
+inline void DiffFieldElem::compile() {
+    bind(compact(child_a.lc - child_b.lc));
+}
+
+inline ProdFieldElem::ProdFieldElem(FieldElem &elem1, FieldElem &elem2, ZKSystem &_system) :
+    child_a(elem1), child_b(elem2), FieldElem(_system) {
+    bits = std::min(elem1.bits + elem2.bits, WIDE_BITS);
+    if (elem1.is_const && elem2.is_const) {
+        is_const = true;
+        val = elem1.val * elem2.val;
+        small_val = is_small() ? elem1.small_val * elem2.small_val : 0;
+    }
+};
+
+inline void ProdFieldElem::compile() {
+    // scaling by a constant stays linear
+    if (child_a.is_const) {
+        bind(child_b.lc * child_a.val);
+        return;
+    }
+    if (child_b.is_const) {
+        bind(child_a.lc * child_b.val);
+        return;
+    }
+
+    if (!has_var) {
+        allocate_var();
+    }
+    system.pb.add_r1cs_constraint(r1cs_constraint<FieldT>(child_a.lc, child_b.lc, pb_var), annotation());
+    lc = pb_var;
+}
+
+inline BitFieldElem::BitFieldElem(FieldElem &_src, size_t _index, ZKSystem &_system) :
+    FieldElem(_system), src(_src), index(_index) {
+    bits = 1;
+};
+
+inline void BitFieldElem::compile() {
+    if (!has_var) {
+        allocate_var();
+    }
+    lc = pb_var;
+}
+
+inline InverseFieldElem::InverseFieldElem(FieldElem &_src, ZKSystem &_system) :
+    FieldElem(_system), src(_src) {};
+
+inline void InverseFieldElem::compile() {
+    if (!has_var) {
+        allocate_var();
+    }
+    lc = pb_var;
+}
+
+inline PackedFieldElem::PackedFieldElem(const std::vector<FieldElem *> &_inputs, ZKSystem &_system) :
+    FieldElem(_system), inputs(_inputs) {
+    size_t input_bits = 0;
+    for (FieldElem *input : inputs) {
+        input_bits = std::max(input_bits, input->bits);
+    }
+    bits = std::min(input_bits + inputs.size(), WIDE_BITS);
+};
+
+inline void PackedFieldElem::compile() {
+    linear_combination<FieldT> expr;
+    FieldT weight = FieldT::one();
+    for (size_t i = inputs.size(); i-- > 0; ) {
+        for (const auto &term : inputs[i]->lc.terms) {
+            expr.add_term(variable<FieldT>(term.index), term.coeff * weight);
+        }
+        weight = weight + weight;
+    }
+    bind(expr);
+}
+
+inline void ZKSystem::enforce_boolean(FieldElem &x) {
+    enforce(x, 1 - x, constant(0L));
+}
+
+inline std::vector<FieldElem *> ZKSystem::decompose(FieldElem &value, size_t width) {
+    // keyed like a node so that decomposing the same value twice doesn't
+    // repeat the constraints
+    FieldElem *&packed = interned[NodeKey{WITNESS_PACK, value.id, width}];
+    if (!packed) {
+        std::vector<FieldElem *> bits;
+        for (size_t i = 0; i < width; i++) {
+            FieldElem &bit = bit_of(value, width - 1 - i);
+            enforce_boolean(bit);
+            bits.push_back(&bit);
+        }
+        packed = &pack(bits);
+        enforce(*packed, constant(1L), value);
+    }
+    return static_cast<PackedFieldElem *>(packed)->inputs;
+}
+
+// Compares two values known to fit in width bits. The top bit of
+// 2^width + a - b (less one when strict) is set exactly when a > b
+// (a >= b), as in libsnark's comparison_gadget: width + 1 booleanity
+// constraints and one packing constraint. That only holds while
+// 2^(width + 1) can't wrap around the field.
+inline FieldElem & packed_compare(FieldElem &a, FieldElem &b, size_t width, bool strict) {
+    if (width + 1 >= FieldT::capacity()) {
+        std::cout << "Can't compare " << width << "-bit values in a " << FieldT::capacity() << "-bit field" << std::endl;
+        throw 1;
+    }
+    ZKSystem &system = a.system;
+    FieldElem *alpha = &(system.power_of_two(width) + a - b);
+    if (strict) {
+        alpha = &(*alpha - 1);
+    }
+
+    return *system.decompose(*alpha, width + 1)[0];
+}
+
+// 1 if x is zero and 0 otherwise. With inv the prover's claimed inverse,
+// x * inv = 1 - out and x * out = 0 leave no freedom: two constraints
+// whatever the width of x.
+inline FieldElem & is_zero(FieldElem &x) {
+    ZKSystem &system = x.system;
+    FieldElem &out = 1 - x * system.inverse_of(x);
+    system.enforce(x, out, system.constant(0L));
+    return out;
+}
+
+inline void ZKSystem::dump(std::ostream &out) {
+    for (FieldElem *elem : elems) {
+        if (elem->live) {
+            out << "x" << elem->id << (elem->pub ? " (public)" : "") << " = " << elem->describe() << endl;
+        }
+    }
+}
+
+// Bits are stored most significant first. Arrays of fresh leaves get
+// their booleanity constraints when they are created; arrays built from
+// other nodes are assumed to be boolean already.
+struct BitArray {
+    std::vector<FieldElem *> bits;
+    int size;
+    ZKSystem &system;
+    // the packed value, built the first time it is asked for
+    FieldElem *packed;
+
+    BitArray(ZKSystem &_system, std::string name, int _size) : system(_system), size(_size), packed(nullptr) {
+        for (int i=0; i<size; i++) {
+            bits.push_back(&system.def(name + std::to_string(i), 1));
+            system.enforce_boolean(*bits.back());
+        }
+    }
+
+    BitArray(ZKSystem &_system, std::vector<FieldElem *> _bits) : system(_system), size(_bits.size()), bits(_bits), packed(nullptr) {}
+
+    // the bits of a value known to fit in _size bits, with one packing
+    // constraint tying them to it
+    BitArray(FieldElem &value, int _size) : size(_size), system(value.system), packed(&value) {
+        bits = system.decompose(value, size);
+    }
+
+    FieldElem & operator[](int i) {
+        return *bits[i];
+    }
+
+    void set(std::vector<int> elems) {
+        for (int i=0; i<size; i++) {
+            bits[i]->set(elems[i]);
+        }
+    }
+
+    void set(unsigned long long x) {
+        for (int i=0; i<size; i++) {
+            const int shift = size - i - 1;
+            bits[i]->set(shift < 64 ? (long) ((x >> shift) & 1) : 0L);
+        }
+    }
+
+    void set(const FieldT &x) {
+        const auto x_bits = x.as_bigint();
+        for (int i=0; i<size; i++) {
+            bits[i]->set(x_bits.test_bit(size - i - 1) ? 1L : 0L);
+        }
+    }
+
+    void make_public() {
+        for (auto bit : bits) {
+            bit->make_public();
+        }
+    }
+
+    std::vector<FieldT> eval() {
+        std::vector<FieldT> vals;
+        for (auto bit : bits) {
+            vals.push_back(bit->eval());
+        }
+        return vals;
+    }
+
+    FieldElem & to_field_elem() {
+        if (!packed) {
+            packed = &system.pack(bits);
+        }
+        return *packed;
+    }
+
+    friend FieldElem & operator>(BitArray &arr1, BitArray &arr2);
+    friend FieldElem & operator<(BitArray &arr1, BitArray &arr2);
+    friend FieldElem & operator>=(BitArray &arr1, BitArray &arr2);
+    friend FieldElem & operator<=(BitArray &arr1, BitArray &arr2);
+    friend FieldElem & operator==(BitArray &arr1, BitArray &arr2);
+
+    friend BitArray operator^(BitArray &arr1, BitArray &arr2);
+};
+
+inline void check_same_size(const BitArray &a, const BitArray &b) {
+    if (a.size != b.size) {
+        std::cout << "Can't compare a " << a.size << "-bit array with a " << b.size << "-bit one" << std::endl;
+        throw 1;
+    }
+}
+
+inline FieldElem & is_greater(BitArray &a, BitArray &b, Comparator comparator) {
+    check_same_size(a, b);
+    if (comparator == COMPARE_PACKED) {
+        return packed_compare(a.to_field_elem(), b.to_field_elem(), a.size, true);
+    }
+
+    FieldElem *out = &((1 - b[0]) * a[0]);  // most significant bit lowest
+    FieldElem *equal = &(a[0] * b[0] + (1 - a[0]) * (1 - b[0]));
+    for (int i=1; i<a.size; i++) {
+        out = &(*out + (1 - *out) * (*equal) * ((1 - b[i]) * a[i]));
+        equal = &(*equal * (a[i] * b[i] + (1 - a[i]) * (1 - b[i])));
+    }
+    FieldElem &out_ref = *out;
+    return out_ref;
+}
+
+inline FieldElem & operator>(BitArray &a, BitArray &b) {
+    return is_greater(a, b, a.system.comparator);
+}
+
+inline FieldElem & operator<(BitArray &a, BitArray &b) {
+    FieldElem &out_ref = b > a;
+    return out_ref;
+}
+
+inline FieldElem & is_equal(BitArray &a, BitArray &b, Comparator comparator) {
+    check_same_size(a, b);
+    if (comparator == COMPARE_PACKED) {
+        // a packed value of more than capacity() bits can wrap mod r, so
+        // that 0 and r would compare equal; wider arrays are compared a
+        // capacity()-bit chunk at a time
+        const size_t chunk_bits = FieldT::capacity();
+        if ((size_t) a.size <= chunk_bits) {
+            return is_zero(a.to_field_elem() - b.to_field_elem());
+        }
+        ZKSystem &system = a.system;
+        FieldElem *out = nullptr;
+        for (size_t begin = 0; begin < (size_t) a.size; begin += chunk_bits) {
+            const size_t end = std::min((size_t) a.size, begin + chunk_bits);
+            std::vector<FieldElem *> a_chunk(a.bits.begin() + begin, a.bits.begin() + end);
+            std::vector<FieldElem *> b_chunk(b.bits.begin() + begin, b.bits.begin() + end);
+            FieldElem &equal = is_zero(system.pack(a_chunk) - system.pack(b_chunk));
+            out = out ? &(*out * equal) : &equal;
+        }
+        return *out;
+    }
+
+    FieldElem *out = &(a[0] * b[0] + (1 - a[0]) * (1 - b[0]));
+    for (int i=1; i<a.size; i++) {
+        out = &(*out * (a[i] * b[i] + (1 - a[i]) * (1 - b[i])));
+    }
+    FieldElem &out_ref = *out;
+    return out_ref;
+}
+
+// the packed form is the cheaper one whichever comparator is selected
+inline FieldElem & operator==(BitArray &a, BitArray &b) {
+    return is_equal(a, b, COMPARE_PACKED);
+}
+
+inline FieldElem & is_greater_equal(BitArray &a, BitArray &b, Comparator comparator) {
+    check_same_size(a, b);
+    if (comparator == COMPARE_PACKED) {
+        return packed_compare(a.to_field_elem(), b.to_field_elem(), a.size, false);
+    }
+
+    FieldElem &agtb = is_greater(a, b, comparator);
+    FieldElem &out = agtb + (1 - agtb) * is_equal(a, b, comparator);
+    return out;
+}
+
+inline FieldElem & operator>=(BitArray &a, BitArray &b) {
+    return is_greater_equal(a, b, a.system.comparator);
+}
+
+inline FieldElem & operator<=(BitArray &a, BitArray &b) {
+    FieldElem &out = b >= a;
+    return out;
+}
+
+// a + b - 2ab is the xor of two booleans with a single product
+inline BitArray operator^(BitArray &a, BitArray &b) {
+    std::vector<FieldElem *> elems;
+    for (int i=0; i<a.size; i++) {
+        elems.push_back(&(a[i] + b[i] - 2 * (a[i] * b[i])));
+    }
+    return BitArray(a.system, elems);
+}
+
+#endif // ZKSYSTEM_HPP_